@@ -0,0 +1,37 @@
+#ifndef TPPL_COMMAND_LINE_H
+#define TPPL_COMMAND_LINE_H
+
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+#include <cmath>
+
+namespace tppl {
+
+// Неотрицательное десятичное число без посторонних символов, не больше max.
+// При ошибке value не меняется.
+inline bool parse_number(const char* text, unsigned long long max, unsigned long long& value) {
+    if (!std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+    errno = 0;
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (errno == ERANGE || *end != '\0' || parsed > max) return false;
+    value = parsed;
+    return true;
+}
+
+// Положительное конечное число секунд, например "0.5" или "2".
+// При ошибке value не меняется.
+inline bool parse_seconds(const char* text, double& value) {
+    if (!std::isdigit(static_cast<unsigned char>(text[0])) && text[0] != '.') return false;
+    errno = 0;
+    char* end = nullptr;
+    double parsed = std::strtod(text, &end);
+    if (errno == ERANGE || end == text || *end != '\0' || !std::isfinite(parsed) || parsed <= 0) return false;
+    value = parsed;
+    return true;
+}
+
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef TPPL_MAPPED_FILE_H
+#define TPPL_MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TPPL_HAVE_MMAP 1
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace tppl {
+
+// Содержимое файла только для чтения: отображение в память, если оно
+// доступно, иначе копия в строке.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef TPPL_HAVE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* mem = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mem != MAP_FAILED) {
+                mapped = mem;
+                length = static_cast<size_t>(st.st_size);
+                opened = true;
+                ::close(fd);
+                return;
+            }
+        }
+        ::close(fd);
+#endif
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return;
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        copy = buffer.str();
+        opened = true;
+    }
+
+    ~MappedFile() {
+#ifdef TPPL_HAVE_MMAP
+        if (mapped) munmap(mapped, length);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const { return opened; }
+
+    std::string_view view() const {
+        if (mapped) return std::string_view(static_cast<const char*>(mapped), length);
+        return copy;
+    }
+
+private:
+    void* mapped = nullptr;
+    size_t length = 0;
+    std::string copy;
+    bool opened = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef TPPL_ORDERED_RUN_H
+#define TPPL_ORDERED_RUN_H
+
+#include <vector>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+
+namespace tppl {
+
+// Выполняет work для i из [0, count) на пуле потоков и передаёт результаты
+// в emit(i, result) в исходном порядке по мере готовности. work вызывается
+// как work(i) или, если принимает номер потока, как work(worker, i), где
+// worker из [0, threads) - для состояния, своего у каждого потока. emit
+// вызывается только из вызывающего потока.
+template <typename Result, typename Work, typename Emit>
+void run_ordered(size_t count, unsigned threads, Work work, Emit emit) {
+    std::vector<std::optional<Result>> slots(count);
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::atomic<size_t> next{0};
+
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(std::max<size_t>(count, 1))));
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            for (size_t i = next++; i < count; i = next++) {
+                Result result = [&] {
+                    if constexpr (std::is_invocable<Work&, unsigned, size_t>::value) return work(t, i);
+                    else return work(i);
+                }();
+                std::lock_guard<std::mutex> lock(mutex);
+                slots[i] = std::move(result);
+                ready.notify_all();
+            }
+        });
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        std::optional<Result> result;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] { return slots[i].has_value(); });
+            result = std::move(slots[i]);
+            slots[i].reset();
+        }
+        emit(i, *result);
+    }
+
+    for (auto& w : workers) w.join();
+}
+
+}
+
+#endif
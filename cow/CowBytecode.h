@@ -0,0 +1,340 @@
+#ifndef COW_BYTECODE_H
+#define COW_BYTECODE_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <stack>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+namespace cow {
+
+enum OpCode : uint32_t {
+    moo = 0, mOo, moO, mOO, Moo, MOo, MoO, MOO, OOO, MMM, OOM, oom, NOP,
+    HALT,
+    // Суперинструкции оптимизатора
+    ADD,        // arg: прибавка к ячейке
+    MOVE,       // arg: сдвиг указателя, aux: минимальный промежуточный сдвиг
+    LOOP_MUL,   // arg: адрес выхода, aux: минимальное смещение в теле цикла
+    MUL_ADD     // arg: смещение ячейки, aux: множитель
+};
+
+// Скомпилированная инструкция: для MOO/moo в arg лежит адрес перехода
+struct Instr {
+    uint32_t op;
+    int32_t arg;
+    int32_t aux;
+};
+
+inline const char* op_name(uint32_t op) {
+    static const char* const names[] = {
+        "moo", "mOo", "moO", "mOO", "Moo", "MOo", "MoO", "MOO", "OOO", "MMM", "OOM", "oom", "NOP",
+        "HALT", "ADD", "MOVE", "LOOP_MUL", "MUL_ADD"
+    };
+    return op < sizeof(names) / sizeof(names[0]) ? names[op] : "?";
+}
+
+// mOO исполняет инструкцию с кодом из ячейки. Коды переходов и сам mOO
+// запрещены, значения вне [0, kIndirectCodes) ничего не делают. Таблицу
+// обработчиков по этому описанию строят интерпретатор и трансляция в C.
+constexpr uint32_t kIndirectCodes = 12;
+
+enum class IndirectKind : uint8_t {
+    Op,
+    LoopError,
+    RecursionError
+};
+
+constexpr IndirectKind indirect_kind(uint32_t code) {
+    return code == moo || code == MOO ? IndirectKind::LoopError
+         : code == mOO ? IndirectKind::RecursionError
+         : IndirectKind::Op;
+}
+
+inline const char* indirect_error(IndirectKind kind) {
+    return kind == IndirectKind::LoopError ? "Cannot exec loop via mOO" : "Recursion forbidden";
+}
+
+// FNV-1a, 64 бита; ключ кэша байткода и подпись дампа трассы
+inline uint64_t hash_source(std::string_view source) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : source) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+namespace detail {
+
+// m -> 0, M -> 1, o -> 2, O -> 3, остальные байты -> 4
+struct Alphabet {
+    uint8_t cls[256];
+    uint8_t ops[64];    // код инструкции по трём символам, NOP если слова нет
+
+    constexpr Alphabet() : cls(), ops() {
+        for (int i = 0; i < 256; i++) cls[i] = 4;
+        cls[static_cast<uint8_t>('m')] = 0;
+        cls[static_cast<uint8_t>('M')] = 1;
+        cls[static_cast<uint8_t>('o')] = 2;
+        cls[static_cast<uint8_t>('O')] = 3;
+
+        const char* words[12] = {
+            "moo", "mOo", "moO", "mOO", "Moo", "MOo", "MoO", "MOO", "OOO", "MMM", "OOM", "oom"
+        };
+        for (int i = 0; i < 64; i++) ops[i] = NOP;
+        for (int op = 0; op < 12; op++) {
+            const char* w = words[op];
+            int key = cls[static_cast<uint8_t>(w[0])] * 16 + cls[static_cast<uint8_t>(w[1])] * 4
+                    + cls[static_cast<uint8_t>(w[2])];
+            ops[key] = static_cast<uint8_t>(op);
+        }
+    }
+};
+
+inline constexpr Alphabet alphabet{};
+
+}
+
+// offsets, если задан, получает смещение каждой инструкции в исходнике
+inline std::vector<OpCode> parse(std::string_view source, std::vector<uint32_t>* offsets = nullptr) {
+    const uint8_t* text = reinterpret_cast<const uint8_t*>(source.data());
+    const size_t length = source.size();
+    const uint8_t* cls = detail::alphabet.cls;
+
+    std::vector<OpCode> instructions;
+    instructions.reserve(length / 4);
+    size_t depth = 0;
+
+    for (size_t i = 0; i + 2 < length; ) {
+        uint8_t a = cls[text[i]];
+        if (a == 4) {
+            i++;
+            continue;
+        }
+        uint8_t b = cls[text[i + 1]];
+        uint8_t c = cls[text[i + 2]];
+        if (b == 4) {
+            i += 2;     // второй символ не из алфавита - слово с него тоже не начнётся
+            continue;
+        }
+        if (c == 4) {
+            i += 3;
+            continue;
+        }
+
+        OpCode op = static_cast<OpCode>(detail::alphabet.ops[a * 16 + b * 4 + c]);
+        if (op == NOP) {
+            i++;
+            continue;
+        }
+
+        if (op == MOO) {
+            depth++;
+        } else if (op == moo) {
+            if (depth == 0) throw std::runtime_error("Unmatched moo");
+            depth--;
+        }
+
+        instructions.push_back(op);
+        if (offsets) offsets->push_back(static_cast<uint32_t>(i));
+        i += 3;
+    }
+
+    if (depth != 0) throw std::runtime_error("Unmatched MOO");
+    return instructions;
+}
+
+// Переводит разобранные инструкции в плоский массив с адресами переходов.
+// MOO прыгает за парный moo, moo возвращается сразу в тело цикла.
+class Compiler {
+public:
+    Compiler(const std::vector<OpCode>& instructions, bool optimize)
+        : instructions(instructions), optimize(optimize) {}
+
+    std::vector<Instr> compile() {
+        std::stack<size_t> loops;
+        code.clear();
+        origins.clear();
+        code.reserve(instructions.size() + 1);
+        origins.reserve(instructions.size() + 1);
+        known = 0;
+
+        for (size_t i = 0; i < instructions.size(); ) {
+            OpCode op = instructions[i];
+            bool folding = optimize;
+
+            // mOO при известном значении ячейки - сразу нужная инструкция;
+            // свёртки читают исходные инструкции, поэтому подставленная
+            // инструкция выпускается как есть
+            if (optimize && op == mOO && known >= 0) {
+                if (known >= kIndirectCodes) {
+                    i++;
+                    continue;
+                }
+                if (indirect_kind(static_cast<uint32_t>(known)) == IndirectKind::Op) {
+                    op = static_cast<OpCode>(known);
+                    folding = false;
+                }
+            }
+
+            if (folding && (op == MoO || op == MOo)) {
+                i = fold_add(i);
+                continue;
+            }
+            if (folding && (op == moO || op == mOo)) {
+                i = fold_move(i);
+                continue;
+            }
+            if (optimize && op == MOO) {
+                size_t next = fold_loop(i);
+                if (next != i) {
+                    i = next;
+                    continue;
+                }
+            }
+
+            size_t pc = code.size();
+            Instr instr{op, 0, 0};
+
+            if (op == MOO) {
+                loops.push(pc);
+            } else if (op == moo) {
+                size_t start = loops.top();
+                loops.pop();
+                code[start].arg = static_cast<int32_t>(pc + 1);
+                instr.arg = static_cast<int32_t>(start + 1);
+            }
+
+            emit(instr, i);
+            track(op);
+            i++;
+        }
+
+        emit({HALT, 0, 0}, instructions.size());
+        return std::move(code);
+    }
+
+    // Для каждой скомпилированной инструкции - индекс первой исходной,
+    // из которой она получена
+    const std::vector<uint32_t>& getOrigins() const { return origins; }
+
+private:
+    const std::vector<OpCode>& instructions;
+    bool optimize;
+    std::vector<Instr> code;
+    std::vector<uint32_t> origins;
+
+    // Значение текущей ячейки, известное при компиляции, или -1. Держится
+    // только в [0, 127], где оно не зависит от ширины ячейки. Во все точки
+    // слияния (за moo и за свёрнутым циклом) управление приходит с нулём.
+    int64_t known = 0;
+
+    void set_known(int64_t value) { known = value >= 0 && value <= 127 ? value : -1; }
+
+    void track(OpCode op) {
+        switch (op) {
+            case moo:
+            case OOO: known = 0; break;
+            case MoO: if (known >= 0) set_known(known + 1); break;
+            case MOo: if (known >= 0) set_known(known - 1); break;
+            case Moo: if (known <= 0) known = -1; break;    // 0 - чтение символа
+            case OOM: break;
+            case mOO: break;    // не заменён - значение неизвестно или исполнение прервётся ошибкой
+            default: known = -1; break;
+        }
+    }
+
+    void emit(const Instr& instr, size_t origin) {
+        code.push_back(instr);
+        origins.push_back(static_cast<uint32_t>(origin));
+    }
+
+    static bool is_simple(OpCode op) {
+        return op == MoO || op == MOo || op == moO || op == mOo;
+    }
+
+    // Серия MoO/MOo -> одна прибавка
+    size_t fold_add(size_t i) {
+        size_t start = i;
+        int64_t delta = 0;
+        for (; i < instructions.size(); i++) {
+            if (instructions[i] == MoO) delta++;
+            else if (instructions[i] == MOo) delta--;
+            else break;
+        }
+        if (delta != 0) emit({ADD, static_cast<int32_t>(static_cast<uint32_t>(delta)), 0}, start);
+        if (known >= 0) set_known(known + delta);
+        return i;
+    }
+
+    // Серия moO/mOo -> один сдвиг с проверкой минимальной позиции
+    size_t fold_move(size_t i) {
+        size_t start = i;
+        int64_t offset = 0, lowest = 0;
+        for (; i < instructions.size(); i++) {
+            if (instructions[i] == moO) offset++;
+            else if (instructions[i] == mOo) lowest = std::min(lowest, --offset);
+            else break;
+        }
+        emit({MOVE, static_cast<int32_t>(offset), static_cast<int32_t>(lowest)}, start);
+        known = -1;
+        return i;
+    }
+
+    // Цикл из одних сдвигов и прибавок с нулевым итоговым сдвигом и шагом
+    // счётчика +-1: обнуление (MOO MOo moo) или умножение/копирование.
+    size_t fold_loop(size_t start) {
+        size_t i = start + 1;
+        while (i < instructions.size() && is_simple(instructions[i])) i++;
+        if (i >= instructions.size() || instructions[i] != moo) return start;
+
+        std::map<int64_t, int64_t> deltas;
+        int64_t offset = 0, lowest = 0;
+        for (size_t j = start + 1; j < i; j++) {
+            switch (instructions[j]) {
+                case MoO: deltas[offset]++; break;
+                case MOo: deltas[offset]--; break;
+                case moO: offset++; break;
+                default: lowest = std::min(lowest, --offset); break;
+            }
+        }
+
+        int64_t step = deltas[0];
+        if (offset != 0 || (step != 1 && step != -1)) return start;
+        if (lowest < INT32_MIN) return start;
+
+        size_t head = code.size();
+        emit({LOOP_MUL, 0, static_cast<int32_t>(lowest)}, start);
+        for (const auto& d : deltas) {
+            if (d.first == 0 || d.second == 0) continue;
+            if (d.first > INT32_MAX) {
+                code.resize(head);
+                origins.resize(head);
+                return start;
+            }
+            // Счётчик проходит -step * v итераций (по модулю разрядности ячейки)
+            int64_t factor = -step * d.second;
+            emit({MUL_ADD, static_cast<int32_t>(d.first),
+                  static_cast<int32_t>(static_cast<uint32_t>(factor))}, start);
+        }
+        emit({OOO, 0, 0}, start);
+
+        if (code.size() == head + 2 && lowest == 0) {
+            // Чистое обнуление ячейки
+            code.erase(code.begin() + static_cast<std::ptrdiff_t>(head));
+            origins.erase(origins.begin() + static_cast<std::ptrdiff_t>(head));
+        } else {
+            code[head].arg = static_cast<int32_t>(code.size());
+        }
+        known = 0;
+        return i + 1;
+    }
+};
+
+}
+
+#endif
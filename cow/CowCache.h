@@ -0,0 +1,221 @@
+#ifndef COW_CACHE_H
+#define COW_CACHE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "CowProgram.h"
+#include "MappedFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cow {
+
+// Файл кэша: заголовок, массив Instr с разрешёнными переходами и смещения
+// инструкций в исходнике. Порядок байтов и выравнивание - как у машины,
+// на которой файл записан; чужой файл отсекается по магии и версии.
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t mode;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint64_t count;         // число инструкций
+    uint64_t checksum;      // hash_source байтов после заголовка
+};
+
+constexpr char kCacheMagic[8] = {'C', 'O', 'W', 'B', 'C', '\0', '\0', '\0'};
+// Увеличивается при любом изменении набора инструкций, их семантики или
+// работы оптимизатора
+constexpr uint32_t kCacheVersion = 3 + (sizeof(Instr) << 8);
+
+inline std::string serialize(const CowProgram& program, uint64_t sourceHash, uint64_t sourceSize) {
+    const std::vector<Instr>& code = program.getCode();
+    const std::vector<uint32_t>& offsets = program.getSourceOffsets();
+
+    CacheHeader header{};
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.version = kCacheVersion;
+    header.mode = static_cast<uint32_t>(program.getMode());
+    header.sourceHash = sourceHash;
+    header.sourceSize = sourceSize;
+    header.count = code.size();
+
+    std::string data(sizeof(header) + code.size() * sizeof(Instr) + offsets.size() * sizeof(uint32_t), '\0');
+    char* at = &data[0];
+    std::memcpy(at, &header, sizeof(header));
+    std::memcpy(at + sizeof(header), code.data(), code.size() * sizeof(Instr));
+    std::memcpy(at + sizeof(header) + code.size() * sizeof(Instr), offsets.data(), offsets.size() * sizeof(uint32_t));
+    header.checksum = hash_source(std::string_view(data).substr(sizeof(header)));
+    std::memcpy(at, &header, sizeof(header));
+    return data;
+}
+
+// Байткод соблюдает то, что гарантирует Compiler и на что полагаются
+// интерпретатор и JIT: MOO и moo попарно ссылаются друг на друга;
+// aux у MOVE - нижняя точка сдвига, у LOOP_MUL - нижнее смещение тела;
+// MUL_ADD стоят только в теле LOOP_MUL (MUL_ADD..., OOO) и не ниже его
+// aux; в конце HALT.
+inline bool verify_code(const std::vector<Instr>& code, const std::vector<uint32_t>& offsets, uint64_t sourceSize) {
+    const size_t count = code.size();
+    std::vector<size_t> loops;
+    size_t body_end = 0;        // конец тела текущего LOOP_MUL
+    int32_t body_lowest = 0;
+
+    for (size_t pc = 0; pc < count; pc++) {
+        const Instr& ins = code[pc];
+        if (ins.op > MUL_ADD || offsets[pc] > sourceSize) return false;
+        if (pc < body_end) {
+            if (pc + 1 == body_end ? ins.op != OOO : (ins.op != MUL_ADD || ins.arg < body_lowest)) return false;
+            continue;
+        }
+        switch (ins.op) {
+            case MOO:
+                loops.push_back(pc);
+                break;
+            case moo: {
+                if (loops.empty()) return false;
+                size_t start = loops.back();
+                loops.pop_back();
+                if (static_cast<int64_t>(code[start].arg) != static_cast<int64_t>(pc) + 1
+                    || static_cast<int64_t>(ins.arg) != static_cast<int64_t>(start) + 1) {
+                    return false;
+                }
+                break;
+            }
+            case MOVE:
+                if (ins.aux == INT32_MIN || ins.aux > std::min(0, ins.arg)) return false;
+                break;
+            case LOOP_MUL:
+                if (ins.aux == INT32_MIN || ins.aux > 0) return false;
+                if (static_cast<int64_t>(ins.arg) < static_cast<int64_t>(pc) + 2
+                    || static_cast<uint64_t>(ins.arg) >= count) {
+                    return false;
+                }
+                body_end = static_cast<size_t>(ins.arg);
+                body_lowest = ins.aux;
+                break;
+            case MUL_ADD:
+                return false;
+            default:
+                break;
+        }
+    }
+    return loops.empty() && code.back().op == HALT;
+}
+
+// nullptr, если данные не от этой версии, не для этого исходника или
+// повреждены: не сошлась контрольная сумма или байткод не прошёл
+// verify_code(), так что испорченный файл не уводит исполнение ни за
+// пределы байткода, ни за пределы ленты.
+inline std::unique_ptr<CowProgram> deserialize(std::string_view data, CowMode mode, uint64_t sourceHash,
+                                               uint64_t sourceSize) {
+    CacheHeader header;
+    if (data.size() < sizeof(header)) return nullptr;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header.version != kCacheVersion) {
+        return nullptr;
+    }
+    if (header.mode != static_cast<uint32_t>(mode) || header.sourceHash != sourceHash
+        || header.sourceSize != sourceSize) {
+        return nullptr;
+    }
+    uint64_t count = header.count;
+    if (count == 0 || count > (data.size() - sizeof(header)) / (sizeof(Instr) + sizeof(uint32_t))
+        || data.size() != sizeof(header) + count * (sizeof(Instr) + sizeof(uint32_t))) {
+        return nullptr;
+    }
+
+    if (hash_source(data.substr(sizeof(header))) != header.checksum) return nullptr;
+
+    std::vector<Instr> code(count);
+    std::vector<uint32_t> offsets(count);
+    std::memcpy(code.data(), data.data() + sizeof(header), count * sizeof(Instr));
+    std::memcpy(offsets.data(), data.data() + sizeof(header) + count * sizeof(Instr), count * sizeof(uint32_t));
+
+    if (!verify_code(code, offsets, sourceSize)) return nullptr;
+
+    return std::make_unique<CowProgram>(mode, std::move(code), std::move(offsets));
+}
+
+// Каталог с байткодом, ключ - хэш и длина исходника плюс режим. Промах
+// компилирует исходник и записывает результат через временный файл и
+// rename, так что параллельные запуски видят либо старый файл, либо новый.
+// load() можно вызывать из нескольких потоков.
+class BytecodeCache {
+public:
+    explicit BytecodeCache(std::string directory) : directory(std::move(directory)) {
+#if defined(__unix__) || defined(__APPLE__)
+        ::mkdir(this->directory.c_str(), 0755);
+#endif
+    }
+
+    std::shared_ptr<const CowProgram> load(std::string_view source, CowMode mode) {
+        uint64_t hash = hash_source(source);
+        std::string path = path_for(hash, source.size(), mode);
+
+        {
+            tppl::MappedFile file(path);
+            if (file.is_open()) {
+                if (auto program = deserialize(file.view(), mode, hash, source.size())) {
+                    hits++;
+                    return program;
+                }
+            }
+        }
+
+        misses++;
+        auto program = std::make_shared<const CowProgram>(source, mode);
+        store(path, serialize(*program, hash, source.size()));
+        return program;
+    }
+
+    size_t getHits() const { return hits; }
+    size_t getMisses() const { return misses; }
+
+private:
+    std::string directory;
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> misses{0};
+    mutable std::atomic<unsigned> writes{0};
+
+    std::string path_for(uint64_t hash, size_t size, CowMode mode) const {
+        char name[64];
+        std::snprintf(name, sizeof(name), "%016llx-%zx-%u.cowbc", static_cast<unsigned long long>(hash), size,
+                      static_cast<unsigned>(mode));
+        return directory + "/" + name;
+    }
+
+    // Ошибки записи не мешают запуску: программа уже скомпилирована
+    void store(const std::string& path, const std::string& data) const {
+        std::string temp = path + ".tmp" + std::to_string(writes++);
+#if defined(__unix__) || defined(__APPLE__)
+        temp += "-" + std::to_string(::getpid());
+#endif
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) return;
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+            if (!out) {
+                out.close();
+                std::remove(temp.c_str());
+                return;
+            }
+        }
+        if (std::rename(temp.c_str(), path.c_str()) != 0) std::remove(temp.c_str());
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,309 @@
+#ifndef COW_CODEGEN_H
+#define COW_CODEGEN_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+#include "CowProgram.h"
+#include "CowTape.h"
+
+namespace cow {
+
+struct CodegenOptions {
+    std::string cell = "int32";     // int8, uint8, int32 или int64, как --cell у cow
+    size_t tapeCells = CowTape::kDefaultCells;
+};
+
+// Переводит байткод программы в исходник на C с той же семантикой, что и
+// у интерпретатора: лента фиксированной ёмкости, арифметика по модулю
+// ширины ячейки, mOO, регистр и ввод-вывод. Ошибки печатаются как у cow,
+// с кодом возврата 1. При сборке с -DCOW_DUMP_STATE программа в конце
+// пишет в stderr указатель, регистр и первые 16 ячеек (для тестов).
+class CEmitter {
+public:
+    CEmitter(const CowProgram& program, const CodegenOptions& options) : program(program), options(options) {}
+
+    void emit(std::ostream& out) {
+        prelude(out);
+        out << "int main(void) {\n";
+        out << "    t = (cell*)calloc(TAPE_CELLS, sizeof(cell));\n";
+        out << "    if (!t) {\n";
+        out << "        fprintf(stderr, \"out of memory\\n\");\n";
+        out << "        return 1;\n";
+        out << "    }\n";
+        body(out);
+        out << "    putchar('\\n');\n";
+        out << "    cow_dump();\n";
+        out << "    return 0;\n";
+        out << "}\n";
+    }
+
+private:
+    const CowProgram& program;
+    const CodegenOptions& options;
+
+    struct CellType {
+        const char* name;
+        const char* c;
+        const char* uc;
+        const char* min;
+        const char* max;
+    };
+
+    const CellType& cell_type() const {
+        static const CellType types[] = {
+            {"int8", "int8_t", "uint8_t", "INT8_MIN", "INT8_MAX"},
+            {"uint8", "uint8_t", "uint8_t", "0", "UINT8_MAX"},
+            {"int32", "int32_t", "uint32_t", "INT32_MIN", "INT32_MAX"},
+            {"int64", "int64_t", "uint64_t", "INT64_MIN", "INT64_MAX"}
+        };
+        for (const CellType& type : types) {
+            if (options.cell == type.name) return type;
+        }
+        throw std::runtime_error("Unknown cell type '" + options.cell + "'");
+    }
+
+    void prelude(std::ostream& out) const {
+        const CellType& type = cell_type();
+        out << "/* Generated by cow2c. Do not edit. */\n"
+            << "#include <stdio.h>\n"
+            << "#include <stdlib.h>\n"
+            << "#include <stdint.h>\n"
+            << "#include <stddef.h>\n\n"
+            << "typedef " << type.c << " cell;\n"
+            << "typedef " << type.uc << " ucell;\n"
+            << "#define CELL_MIN ((long long)" << type.min << ")\n"
+            << "#define CELL_MAX ((long long)" << type.max << ")\n"
+            << "#define TAPE_CELLS ((size_t)" << options.tapeCells << "u)\n\n";
+
+        out << R"(static cell* t;
+static size_t p;
+static cell reg;
+static int reg_loaded;
+static int in_failed;
+
+static inline void cow_dump(void) {
+#ifdef COW_DUMP_STATE
+    size_t i;
+    fprintf(stderr, "state %zu %lld %d", p, (long long)reg, reg_loaded);
+    for (i = 0; i < 16; i++) fprintf(stderr, " %lld", i < TAPE_CELLS ? (long long)t[i] : 0ll);
+    fprintf(stderr, "\n");
+#endif
+}
+
+static inline void cow_error(const char* message) {
+    fflush(stdout);
+    fprintf(stderr, "\nruntime error: %s\n", message);
+    cow_dump();
+    exit(1);
+}
+
+static inline cell cow_add(cell a, long long b) {
+    return (cell)(ucell)((uint64_t)a + (uint64_t)b);
+}
+
+static inline cell cow_mul(cell a, long long b) {
+    return (cell)(ucell)((uint64_t)a * (uint64_t)b);
+}
+
+static inline void cow_left(void) {
+    if (p == 0) cow_error("Memory Underflow");
+    p--;
+}
+
+static inline void cow_right(void) {
+    if (p + 1 >= TAPE_CELLS) cow_error("Memory Overflow");
+    p++;
+}
+
+static inline void cow_lowest(long long lowest) {
+    if ((long long)p + lowest < 0) cow_error("Memory Underflow");
+}
+
+static inline void cow_move(long long offset, long long lowest) {
+    size_t next;
+    cow_lowest(lowest);
+    next = p + (size_t)offset;
+    if (next >= TAPE_CELLS) cow_error("Memory Overflow");
+    p = next;
+}
+
+static inline void cow_mul_add(long long offset, long long factor) {
+    size_t target = p + (size_t)offset;
+    if (target >= TAPE_CELLS) cow_error("Memory Overflow");
+    t[target] = cow_add(t[target], (long long)cow_mul(t[p], factor));
+}
+
+static inline void cow_char_io(void) {
+    if (t[p] == 0) {
+        int ch = EOF;
+        fflush(stdout);
+        if (!in_failed) ch = getchar();
+        if (ch == EOF) {
+            in_failed = 1;
+            t[p] = 0;
+        } else {
+            t[p] = (cell)(unsigned char)ch;
+        }
+    } else {
+        putchar((unsigned char)t[p]);
+    }
+}
+
+static inline int cow_is_space(int ch) {
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+/* Like in >> int: spaces, sign, digits. A number outside the cell range or
+   end of input is a failure, after which no more input is read. */
+static inline void cow_read_int(void) {
+    unsigned long long limit, magnitude = 0;
+    int ch, negative = 0, digits = 0, overflow = 0;
+    fflush(stdout);
+    if (in_failed) return;
+
+    ch = getchar();
+    while (ch != EOF && cow_is_space(ch)) ch = getchar();
+    if (ch == EOF) {
+        in_failed = 1;
+        return;
+    }
+    if (ch == '-' || ch == '+') {
+        negative = ch == '-';
+        ch = getchar();
+    }
+
+    limit = negative ? 0ull - (unsigned long long)CELL_MIN : (unsigned long long)CELL_MAX;
+    while (ch != EOF && ch >= '0' && ch <= '9') {
+        unsigned digit = (unsigned)(ch - '0');
+        digits = 1;
+        if (magnitude > (limit - digit) / 10 || digit > limit) overflow = 1;
+        else magnitude = magnitude * 10 + digit;
+        ch = getchar();
+    }
+    if (ch != EOF) ungetc(ch, stdin);
+
+    if (!digits || overflow || ch == EOF) in_failed = 1;
+    if (!digits || overflow) return;
+    t[p] = (cell)(negative ? (long long)(0ull - magnitude) : (long long)magnitude);
+}
+
+static inline void cow_register(void) {
+    if (reg_loaded) {
+        t[p] = reg;
+        reg = 0;
+        reg_loaded = 0;
+    } else {
+        reg = t[p];
+        reg_loaded = 1;
+    }
+}
+
+)";
+        indirect_table(out);
+    }
+
+    // mOO: таблица обработчиков по значению ячейки, как у интерпретатора
+    static void indirect_table(std::ostream& out) {
+        out << "static void cow_loop_error(void) { cow_error(\"" << indirect_error(IndirectKind::LoopError) << "\"); }\n"
+            << "static void cow_recursion_error(void) { cow_error(\""
+            << indirect_error(IndirectKind::RecursionError) << "\"); }\n";
+        for (uint32_t code = 0; code < kIndirectCodes; code++) {
+            if (indirect_kind(code) != IndirectKind::Op) continue;
+            out << "static void cow_op_" << op_name(code) << "(void) { "
+                << statement(Instr{code, 0, 0}) << " }\n";
+        }
+
+        out << "static void (*const cow_handlers[" << kIndirectCodes << "])(void) = {\n";
+        for (uint32_t code = 0; code < kIndirectCodes; code++) {
+            switch (indirect_kind(code)) {
+                case IndirectKind::LoopError: out << "    cow_loop_error"; break;
+                case IndirectKind::RecursionError: out << "    cow_recursion_error"; break;
+                default: out << "    cow_op_" << op_name(code); break;
+            }
+            out << (code + 1 < kIndirectCodes ? ",\n" : "\n");
+        }
+        out << "};\n\n";
+
+        out << "static inline void cow_indirect(void) {\n"
+            << "    uint64_t code = (uint64_t)(long long)t[p];\n"
+            << "    if (code < " << kIndirectCodes << ") cow_handlers[code]();\n"
+            << "}\n\n";
+    }
+
+    // Оператор C для инструкции без перехода; пустая строка - нечего выводить
+    static std::string statement(const Instr& ins) {
+        switch (ins.op) {
+            case mOo: return "cow_left();";
+            case moO: return "cow_right();";
+            case mOO: return "cow_indirect();";
+            case Moo: return "cow_char_io();";
+            case MOo: return "t[p] = cow_add(t[p], -1);";
+            case MoO: return "t[p] = cow_add(t[p], 1);";
+            case OOO: return "t[p] = 0;";
+            case MMM: return "cow_register();";
+            case OOM: return "printf(\"%lld\", (long long)t[p]);";
+            case oom: return "cow_read_int();";
+            case ADD: return "t[p] = cow_add(t[p], " + std::to_string(ins.arg) + "ll);";
+            case MOVE: return "cow_move(" + std::to_string(ins.arg) + "ll, " + std::to_string(ins.aux) + "ll);";
+            case MUL_ADD:
+                return "cow_mul_add(" + std::to_string(ins.arg) + "ll, " + std::to_string(ins.aux) + "ll);";
+            default: return "";
+        }
+    }
+
+    static bool same(const Instr& a, const Instr& b) {
+        return a.op == b.op && a.arg == b.arg && a.aux == b.aux;
+    }
+
+    // MOO и LOOP_MUL открывают блок, который закрывается перед адресом выхода.
+    // Длинные серии одинаковых инструкций (Basic-режим, подряд идущие Moo)
+    // сворачиваются в цикл, иначе компилятору C достаётся огромная main.
+    void body(std::ostream& out) const {
+        const std::vector<Instr>& code = program.getCode();
+        std::vector<size_t> open;
+        std::string indent = "    ";
+
+        for (size_t pc = 0; pc < code.size(); pc++) {
+            while (!open.empty() && open.back() == pc) {
+                open.pop_back();
+                indent.resize(indent.size() - 4);
+                out << indent << "}\n";
+            }
+
+            const Instr& ins = code[pc];
+            if (ins.op == MOO || ins.op == LOOP_MUL) {
+                out << indent << (ins.op == MOO ? "while" : "if") << " (t[p] != 0) {\n";
+                open.push_back(static_cast<size_t>(ins.arg));
+                indent += "    ";
+                if (ins.op == LOOP_MUL) out << indent << "cow_lowest(" << ins.aux << "ll);\n";
+                continue;
+            }
+
+            std::string text = statement(ins);
+            if (text.empty()) continue;
+
+            size_t end = pc + 1;
+            size_t limit = open.empty() ? code.size() : open.back();
+            while (end < limit && same(code[end], ins)) end++;
+            if (end - pc >= kRepeat) {
+                out << indent << "{ long n; for (n = 0; n < " << (end - pc) << "; n++) " << text << " }\n";
+                pc = end - 1;
+            } else {
+                out << indent << text << "\n";
+            }
+        }
+    }
+
+    static constexpr size_t kRepeat = 8;
+};
+
+inline void emit_c(const CowProgram& program, std::ostream& out, const CodegenOptions& options = {}) {
+    CEmitter(program, options).emit(out);
+}
+
+}
+
+#endif
@@ -0,0 +1,461 @@
+#ifndef COW_EXECUTION_H
+#define COW_EXECUTION_H
+
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+#include <exception>
+#include <cstdint>
+#include <climits>
+#include <chrono>
+#include <utility>
+#include <limits>
+#include <type_traits>
+#include "CowProgram.h"
+#include "CowProfile.h"
+#include "CowTrace.h"
+#include "CowTape.h"
+#include "CowIO.h"
+
+// COW_NO_COMPUTED_GOTO оставляет переносимый switch и на GCC/Clang
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(COW_NO_COMPUTED_GOTO)
+#define COW_COMPUTED_GOTO 1
+#endif
+
+enum class CowStatus {
+    Finished,
+    Suspended   // бюджет шагов исчерпан, можно продолжить через resume()
+};
+
+// Состояние одного исполнения: лента, регистр и потоки ввода-вывода.
+// Программа передаётся извне и не меняется, так что разные исполнения
+// одной программы независимы.
+//
+// Cell - тип ячейки ленты (int8_t, uint8_t, int32_t, int64_t). Арифметика
+// ведётся по модулю 2^N для разрядности ячейки, oom принимает только числа
+// из диапазона типа. Машинный код есть только для int32_t, остальные
+// ширины в режиме Jit исполняются оптимизированным байткодом.
+template <typename Cell>
+class BasicCowExecution {
+    static_assert(std::is_integral<Cell>::value && sizeof(Cell) <= sizeof(int64_t) && !std::is_same<Cell, bool>::value,
+                  "COW cell must be an integer type");
+
+public:
+    BasicCowExecution(std::istream& in = std::cin, std::ostream& out = std::cout,
+                      size_t tapeCells = BasicCowTape<Cell>::kDefaultCells)
+        : memory(tapeCells), ptr(0), reg(0), reg_loaded(false), input(in), output(out) {}
+
+    BasicCowExecution(const BasicCowExecution&) = delete;
+    BasicCowExecution& operator=(const BasicCowExecution&) = delete;
+
+    void run(const CowProgram& program) {
+        reset();
+        try {
+            execute(program);
+        } catch (...) {
+            output.flush();
+            throw;
+        }
+        output.flush();
+    }
+
+    // Запуск со сбором профиля: всегда через байткод, JIT не используется
+    void runProfiled(const CowProgram& program, CowProfile& result) {
+        reset();
+        result.clear(program.getCode().size());
+        profile = &result;
+        loops.clear();
+        auto begin = std::chrono::steady_clock::now();
+        try {
+            dispatch<kProfile>(program.getCode(), 0, 0);
+        } catch (...) {
+            finish_profile(begin);
+            output.flush();
+            throw;
+        }
+        finish_profile(begin);
+        output.flush();
+    }
+
+    // Пошаговый режим: start() готовит исполнение, resume(n) выполняет не более
+    // n инструкций байткода. Состояние (pc, лента, регистр) сохраняется между
+    // вызовами. Всегда работает через байткод, даже для программ в режиме Jit.
+    void start(const CowProgram& program) {
+        reset();
+        current = &program;
+        pc = 0;
+    }
+
+    CowStatus resume(size_t maxSteps) {
+        if (!current) return CowStatus::Finished;
+        size_t next;
+        try {
+            next = trace ? dispatch<kBudget | kTrace>(current->getCode(), pc, maxSteps)
+                         : dispatch<kBudget>(current->getCode(), pc, maxSteps);
+        } catch (...) {
+            current = nullptr;
+            output.flush();
+            throw;
+        }
+        output.flush();
+        if (next == kHalted) {
+            current = nullptr;
+            return CowStatus::Finished;
+        }
+        pc = next;
+        return CowStatus::Suspended;
+    }
+
+    // Трассировка: пока кольцо задано, каждая инструкция байткода перед
+    // выполнением записывается в него (JIT при этом не используется).
+    // Кольцо не очищается между запусками, его содержимое после ошибки -
+    // последние шаги до неё.
+    void setTrace(cow::TraceRing* ring) { trace = ring; }
+
+    // Число инструкций байткода, выполненных в пошаговом режиме с последнего start()
+    uint64_t getSteps() const { return steps; }
+
+    Cell getValueAt(size_t index) const {
+        if (index < memory.size()) return memory[index];
+        return 0;
+    }
+
+    size_t getPointer() const { return ptr; }
+    Cell getRegister() const { return reg; }
+    bool isRegisterLoaded() const { return reg_loaded; }
+
+private:
+    using Unsigned = std::make_unsigned_t<Cell>;
+
+    BasicCowTape<Cell> memory;
+    size_t ptr;
+    Cell reg;
+    bool reg_loaded;
+
+    cow::InputReader input;
+    cow::OutputBuffer output;
+
+    std::exception_ptr jit_error;
+
+    // Пошаговый режим
+    const CowProgram* current = nullptr;
+    size_t pc = 0;
+    uint64_t steps = 0;
+
+    // Профилирование: открытые циклы - адрес MOO и время входа
+    CowProfile* profile = nullptr;
+    cow::TraceRing* trace = nullptr;
+    std::vector<std::pair<size_t, std::chrono::steady_clock::time_point>> loops;
+
+    // Возможности цикла исполнения, выбираемые при компиляции
+    enum Features : unsigned {
+        kPlain = 0,
+        kBudget = 1,    // остановка после заданного числа инструкций
+        kProfile = 2,   // счётчики инструкций и время циклов
+        kTrace = 4      // запись шагов в кольцо трассы
+    };
+    static constexpr size_t kHalted = SIZE_MAX;
+
+    void reset() {
+        current = nullptr;
+        pc = 0;
+        steps = 0;
+        input.reset();
+        memory.clear();
+        ptr = 0;
+        reg = 0;
+        reg_loaded = false;
+    }
+
+    void execute(const CowProgram& program) {
+        if (trace) {
+            dispatch<kTrace>(program.getCode(), 0, 0);
+            return;
+        }
+        if constexpr (std::is_same<Cell, int32_t>::value) {
+            if (const cow::JitCode* jit = program.getJit({&jit_slow})) {
+                run_jit(*jit);
+                return;
+            }
+        }
+        dispatch<kPlain>(program.getCode(), 0, 0);
+    }
+
+    void move_right() {
+        if (ptr + 1 >= memory.size()) throw std::runtime_error("Memory Overflow");
+        ptr++;
+    }
+
+    void move_left() {
+        if (ptr == 0) throw std::runtime_error("Memory Underflow");
+        ptr--;
+    }
+
+    void move_by(int32_t offset, int32_t lowest) {
+        if (static_cast<int64_t>(ptr) + lowest < 0) throw std::runtime_error("Memory Underflow");
+        size_t next = ptr + static_cast<size_t>(static_cast<int64_t>(offset));
+        if (next >= memory.size()) throw std::runtime_error("Memory Overflow");
+        ptr = next;
+    }
+
+    // Беззнаковая арифметика нужной ширины; uint64_t вместо Unsigned, чтобы
+    // узкие типы не расширялись до int
+    static Cell wrap_add(Cell a, int32_t b) {
+        return static_cast<Cell>(static_cast<Unsigned>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b)));
+    }
+
+    static Cell wrap_mul(Cell a, int32_t b) {
+        return static_cast<Cell>(static_cast<Unsigned>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b)));
+    }
+
+    // Возвращает kHalted по завершении программы или адрес, с которого
+    // нужно продолжить после исчерпания бюджета
+    template <unsigned F>
+    size_t dispatch(const std::vector<cow::Instr>& code, size_t start, size_t budget) {
+        const cow::Instr* base = code.data();
+        const cow::Instr* ip = base + start;
+        size_t left = budget;
+        uint64_t* counts = (F & kProfile) ? profile->counts.data() : nullptr;
+#define COW_COUNT() {                                                                          \
+            if (F & kProfile) counts[ip - base]++;                                                 \
+            if (F & kTrace) trace->record(static_cast<uint32_t>(ip - base), ip->op, ptr,           \
+                                          static_cast<int64_t>(memory[ptr]));                      \
+        }
+
+#ifdef COW_COMPUTED_GOTO
+        static void* const labels[] = {
+            &&L_moo, &&L_mOo, &&L_moO, &&L_mOO, &&L_Moo, &&L_MOo, &&L_MoO,
+            &&L_MOO, &&L_OOO, &&L_MMM, &&L_OOM, &&L_oom, &&L_NOP, &&L_HALT,
+            &&L_ADD, &&L_MOVE, &&L_LOOP_MUL, &&L_MUL_ADD
+        };
+#define COW_CASE(name) L_##name:
+#define COW_NEXT() { if ((F & kBudget) && left-- == 0) goto suspend; COW_COUNT(); goto *labels[ip->op]; }
+        COW_NEXT();
+#else
+#define COW_CASE(name) case cow::name:
+#define COW_NEXT() continue;
+        // бюджет проверяется перед каждой инструкцией, включая первую
+        for (;;) {
+            if ((F & kBudget) && left-- == 0) goto suspend;
+            COW_COUNT();
+            switch (ip->op) {
+#endif
+        COW_CASE(MOO)
+            if ((F & kProfile) && memory[ptr] != 0) loop_enter(static_cast<size_t>(ip - base));
+            ip = memory[ptr] == 0 ? base + ip->arg : ip + 1;
+            COW_NEXT();
+        COW_CASE(moo)
+            if ((F & kProfile) && memory[ptr] == 0) loop_exit();
+            ip = memory[ptr] != 0 ? base + ip->arg : ip + 1;
+            COW_NEXT();
+        COW_CASE(mOo)
+            move_left();
+            ++ip;
+            COW_NEXT();
+        COW_CASE(moO)
+            move_right();
+            ++ip;
+            COW_NEXT();
+        COW_CASE(mOO)
+            indirect();
+            ++ip;
+            COW_NEXT();
+        COW_CASE(Moo)
+            char_io();
+            ++ip;
+            COW_NEXT();
+        COW_CASE(MOo)
+            memory[ptr] = wrap_add(memory[ptr], -1);
+            ++ip;
+            COW_NEXT();
+        COW_CASE(MoO)
+            memory[ptr] = wrap_add(memory[ptr], 1);
+            ++ip;
+            COW_NEXT();
+        COW_CASE(OOO)
+            memory[ptr] = 0;
+            ++ip;
+            COW_NEXT();
+        COW_CASE(MMM)
+            register_op();
+            ++ip;
+            COW_NEXT();
+        COW_CASE(OOM)
+            output.put_int(memory[ptr]);
+            ++ip;
+            COW_NEXT();
+        COW_CASE(oom)
+            read_int();
+            ++ip;
+            COW_NEXT();
+        COW_CASE(NOP)   		// LCOV_EXCL_LINE
+            ++ip;       		// LCOV_EXCL_LINE
+            COW_NEXT(); 		// LCOV_EXCL_LINE
+        COW_CASE(ADD)
+            memory[ptr] = wrap_add(memory[ptr], ip->arg);
+            ++ip;
+            COW_NEXT();
+        COW_CASE(MOVE)
+            move_by(ip->arg, ip->aux);
+            ++ip;
+            COW_NEXT();
+        COW_CASE(LOOP_MUL)
+            if (memory[ptr] == 0) {
+                ip = base + ip->arg;
+                COW_NEXT();
+            }
+            if (static_cast<int64_t>(ptr) + ip->aux < 0) throw std::runtime_error("Memory Underflow");
+            ++ip;
+            COW_NEXT();
+        COW_CASE(MUL_ADD)
+            {
+                size_t target = ptr + static_cast<size_t>(static_cast<int64_t>(ip->arg));
+                if (target >= memory.size()) throw std::runtime_error("Memory Overflow");
+                memory[target] = wrap_add(memory[target], wrap_mul(memory[ptr], ip->aux));
+            }
+            ++ip;
+            COW_NEXT();
+        COW_CASE(HALT)
+            if (F & kBudget) steps += budget - left;
+            return kHalted;
+#ifndef COW_COMPUTED_GOTO
+            }
+        }
+#endif
+    suspend:
+        steps += budget;
+        return static_cast<size_t>(ip - base);
+#undef COW_CASE
+#undef COW_NEXT
+#undef COW_COUNT
+    }
+
+    void loop_enter(size_t pc) {
+        loops.emplace_back(pc, std::chrono::steady_clock::now());
+    }
+
+    void loop_exit() {
+        auto now = std::chrono::steady_clock::now();
+        profile->loopNanos[loops.back().first] += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - loops.back().second).count());
+        loops.pop_back();
+    }
+
+    // Циклы, оставшиеся открытыми после ошибки, закрываются временем остановки
+    void finish_profile(std::chrono::steady_clock::time_point begin) {
+        while (!loops.empty()) loop_exit();
+        profile->elapsed = std::chrono::steady_clock::now() - begin;
+        profile = nullptr;
+    }
+
+    void run_jit(const cow::JitCode& jit) {
+        cow::JitContext ctx{memory.data(), memory.size(), ptr, this};
+        int status = jit.run(&ctx);
+        ptr = ctx.ptr;
+        if (status == cow::JIT_UNDERFLOW) throw std::runtime_error("Memory Underflow");
+        if (status == cow::JIT_OVERFLOW) throw std::runtime_error("Memory Overflow");
+        if (status == cow::JIT_ERROR) {
+            std::exception_ptr error = jit_error;
+            jit_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    static void jit_sync(cow::JitContext* ctx, BasicCowExecution* self) {
+        ctx->base = self->memory.data();
+        ctx->size = self->memory.size();
+        ctx->ptr = self->ptr;
+    }
+
+    static int jit_slow(cow::JitContext* ctx, uint32_t op) {
+        BasicCowExecution* self = static_cast<BasicCowExecution*>(ctx->owner);
+        self->ptr = ctx->ptr;
+        int status = cow::JIT_OK;
+        try {
+            switch (op) {
+                case cow::mOO: self->indirect(); break;
+                case cow::Moo: self->char_io(); break;
+                case cow::OOM: self->print_int(); break;
+                case cow::oom: self->read_int(); break;
+                case cow::MMM: self->register_op(); break;
+                default: break;
+            }
+        } catch (...) {
+            self->jit_error = std::current_exception();
+            status = cow::JIT_ERROR;
+        }
+        jit_sync(ctx, self);
+        return status;
+    }
+
+    // mOO: обработчик по значению ячейки, таблица - после класса
+    using Handler = void (BasicCowExecution::*)();
+    static const Handler handlers[cow::kIndirectCodes];
+
+    void indirect() {
+        Cell code = memory[ptr];
+        if (static_cast<uint64_t>(code) < cow::kIndirectCodes) (this->*handlers[code])();
+    }
+
+    void loop_error() { throw std::runtime_error(cow::indirect_error(cow::IndirectKind::LoopError)); }
+    void recursion_error() { throw std::runtime_error(cow::indirect_error(cow::IndirectKind::RecursionError)); }
+    void decrement() { memory[ptr] = wrap_add(memory[ptr], -1); }
+    void increment() { memory[ptr] = wrap_add(memory[ptr], 1); }
+    void zero() { memory[ptr] = 0; }
+    void print_int() { output.put_int(memory[ptr]); }
+
+    void char_io() {
+        if (memory[ptr] == 0) {
+            char c = 0;
+            sync_output();
+            if (input.get(c)) memory[ptr] = static_cast<Cell>(static_cast<unsigned char>(c));
+            else memory[ptr] = 0;
+        } else {
+            output.put(static_cast<char>(memory[ptr]));
+        }
+    }
+
+    void register_op() {
+        if (reg_loaded) {
+            memory[ptr] = reg;
+            reg = 0;
+            reg_loaded = false;
+        } else {
+            reg = memory[ptr];
+            reg_loaded = true;
+        }
+    }
+
+    void read_int() {
+        long long val = 0;
+        sync_output();
+        if (input.read_int(val, std::numeric_limits<Cell>::min(), std::numeric_limits<Cell>::max())) {
+            memory[ptr] = static_cast<Cell>(val);
+        }
+    }
+
+    void sync_output() {
+        output.flush();
+        input.flush_tied();
+    }
+};
+
+template <typename Cell>
+const typename BasicCowExecution<Cell>::Handler BasicCowExecution<Cell>::handlers[cow::kIndirectCodes] = {
+    &BasicCowExecution::loop_error,         // moo
+    &BasicCowExecution::move_left,          // mOo
+    &BasicCowExecution::move_right,         // moO
+    &BasicCowExecution::recursion_error,    // mOO
+    &BasicCowExecution::char_io,            // Moo
+    &BasicCowExecution::decrement,          // MOo
+    &BasicCowExecution::increment,          // MoO
+    &BasicCowExecution::loop_error,         // MOO
+    &BasicCowExecution::zero,               // OOO
+    &BasicCowExecution::register_op,        // MMM
+    &BasicCowExecution::print_int,          // OOM
+    &BasicCowExecution::read_int            // oom
+};
+
+using CowExecution = BasicCowExecution<int32_t>;
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef COW_IO_H
+#define COW_IO_H
+
+#include <iostream>
+#include <streambuf>
+#include <charconv>
+#include <climits>
+#include <cstddef>
+#include <memory>
+
+namespace cow {
+
+// Накапливает вывод Moo/OOM и отдаёт его потоку крупными блоками
+class OutputBuffer {
+public:
+    static constexpr size_t kCapacity = 1 << 16;
+
+    explicit OutputBuffer(std::ostream& out) : out(out), buffer(new char[kCapacity]) {}
+    ~OutputBuffer() { flush(); }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void put(char c) {
+        if (used == kCapacity) flush();
+        buffer[used++] = c;
+    }
+
+    void put_int(long long value) {
+        if (kCapacity - used < 24) flush();
+        auto result = std::to_chars(buffer.get() + used, buffer.get() + kCapacity, value);
+        used = static_cast<size_t>(result.ptr - buffer.get());
+    }
+
+    void flush() {
+        if (used == 0) return;
+        out.write(buffer.get(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+
+private:
+    std::ostream& out;
+    std::unique_ptr<char[]> buffer;
+    size_t used = 0;
+};
+
+// Чтение байтов и целых чисел напрямую из буфера потока, без sentry и
+// локали. Повторяет поведение in.get(c) и in >> int: после первой неудачи
+// все последующие чтения тоже неудачны.
+class InputReader {
+public:
+    explicit InputReader(std::istream& in) : in(in) {}
+
+    void reset() { failed = !in.good(); }
+
+    // Поток, привязанный к вводу (std::cout для std::cin), сбрасывается перед чтением
+    void flush_tied() {
+        if (std::ostream* tied = in.tie()) tied->flush();
+    }
+
+    bool get(char& c) {
+        if (failed) return false;
+        int ch = in.rdbuf()->sbumpc();
+        if (ch == std::char_traits<char>::eof()) return fail(std::ios::eofbit | std::ios::failbit);
+        c = static_cast<char>(ch);
+        return true;
+    }
+
+    // Целое в диапазоне [low, high]; число вне диапазона - неудачное чтение
+    bool read_int(long long& value, long long low, long long high) {
+        if (failed) return false;
+        std::streambuf* sb = in.rdbuf();
+        const int eof = std::char_traits<char>::eof();
+
+        int ch = sb->sgetc();
+        while (ch != eof && is_space(ch)) ch = sb->snextc();
+        if (ch == eof) return fail(std::ios::eofbit | std::ios::failbit);
+
+        bool negative = false;
+        if (ch == '-' || ch == '+') {
+            negative = ch == '-';
+            ch = sb->snextc();
+        }
+
+        // Модуль копится без знака; при переполнении цифры всё равно дочитываются
+        unsigned long long limit = negative ? 0ull - static_cast<unsigned long long>(low)
+                                            : static_cast<unsigned long long>(high);
+        unsigned long long magnitude = 0;
+        bool digits = false, overflow = false;
+        while (ch != eof && ch >= '0' && ch <= '9') {
+            digits = true;
+            unsigned digit = static_cast<unsigned>(ch - '0');
+            if (magnitude > (limit - digit) / 10 || digit > limit) overflow = true;
+            else magnitude = magnitude * 10 + digit;
+            ch = sb->snextc();
+        }
+
+        if (!digits || overflow) return fail((ch == eof ? std::ios::eofbit : std::ios::goodbit) | std::ios::failbit);
+        if (ch == eof) {
+            // как и у потока, после eofbit следующие чтения не выполняются
+            failed = true;
+            in.setstate(std::ios::eofbit);
+        }
+
+        value = negative ? static_cast<long long>(0ull - magnitude) : static_cast<long long>(magnitude);
+        return true;
+    }
+
+private:
+    std::istream& in;
+    bool failed = false;
+
+    static bool is_space(int ch) {
+        return ch == ' ' || (ch >= '\t' && ch <= '\r');
+    }
+
+    bool fail(std::ios::iostate state) {
+        failed = true;
+        in.setstate(state);
+        return false;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,293 @@
+#ifndef COW_JIT_H
+#define COW_JIT_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include "CowBytecode.h"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__))
+#define COW_JIT_X86_64 1
+#include <sys/mman.h>
+#endif
+
+namespace cow {
+
+// Состояние ленты, которое машинный код держит в регистрах; size - ёмкость
+// зарезервированной ленты, за которой стоит защитная страница
+struct JitContext {
+    int* base;
+    size_t size;
+    size_t ptr;
+    void* owner;
+};
+
+enum JitStatus : int {
+    JIT_OK = 0,
+    JIT_ERROR = 1,      // исключение сохранено владельцем
+    JIT_UNDERFLOW = 2,
+    JIT_OVERFLOW = 3
+};
+
+// Обратный вызов в интерпретатор для Moo, OOM, oom, MMM и mOO. Возвращает
+// JitStatus и обновляет ptr в контексте.
+struct JitHooks {
+    int (*slow)(JitContext* ctx, uint32_t op);
+};
+
+class JitCode {
+public:
+    JitCode(const std::vector<Instr>& code, const JitHooks& hooks) {
+#ifdef COW_JIT_X86_64
+        Assembler a(hooks);
+        if (!a.compile(code)) return;
+
+        size_t length = a.bytes.size();
+        void* mem = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) return;
+        std::memcpy(mem, a.bytes.data(), length);
+        if (mprotect(mem, length, PROT_READ | PROT_EXEC) != 0) {
+            munmap(mem, length);
+            return;
+        }
+        entry = mem;
+        size = length;
+#else
+        (void)code;
+        (void)hooks;
+#endif
+    }
+
+    ~JitCode() {
+#ifdef COW_JIT_X86_64
+        if (entry) munmap(entry, size);
+#endif
+    }
+
+    JitCode(const JitCode&) = delete;
+    JitCode& operator=(const JitCode&) = delete;
+
+    static bool available() {
+#ifdef COW_JIT_X86_64
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool valid() const { return entry != nullptr; }
+
+    int run(JitContext* ctx) const {
+        using Fn = int (*)(JitContext*);
+        return reinterpret_cast<Fn>(entry)(ctx);
+    }
+
+private:
+    void* entry = nullptr;
+    size_t size = 0;
+
+#ifdef COW_JIT_X86_64
+    // rbx = контекст, r12 = индекс ячейки, r13 = начало ленты, r14 = ёмкость ленты
+    class Assembler {
+    public:
+        std::vector<uint8_t> bytes;
+
+        explicit Assembler(const JitHooks& hooks) : hooks(hooks) {}
+
+        bool compile(const std::vector<Instr>& code) {
+            std::vector<size_t> offsets(code.size());
+
+            prologue();
+            for (size_t pc = 0; pc < code.size(); pc++) {
+                offsets[pc] = bytes.size();
+                if (!instruction(code[pc])) return false;
+            }
+
+            size_t epilogue_at = bytes.size();
+            emit({0x4C, 0x89, 0x63, PTR});          // mov [rbx+ptr], r12
+            emit({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3});
+
+            size_t underflow_at = bytes.size();
+            emit({0xB8});                           // mov eax, JIT_UNDERFLOW
+            emit32(JIT_UNDERFLOW);
+            jump(0xE9, EPILOGUE);
+
+            size_t overflow_at = bytes.size();
+            emit({0xB8});                           // mov eax, JIT_OVERFLOW
+            emit32(JIT_OVERFLOW);
+            jump(0xE9, EPILOGUE);
+
+            for (const Fixup& f : fixups) {
+                size_t target;
+                if (f.target == EPILOGUE) target = epilogue_at;
+                else if (f.target == UNDERFLOW) target = underflow_at;
+                else if (f.target == OVERFLOW) target = overflow_at;
+                else target = offsets[static_cast<size_t>(f.target)];
+                int32_t rel = static_cast<int32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(f.at + 4));
+                std::memcpy(&bytes[f.at], &rel, 4);
+            }
+            return true;
+        }
+
+    private:
+        enum : int64_t { EPILOGUE = -1, UNDERFLOW = -2, OVERFLOW = -3 };
+        enum : uint8_t { BASE = offsetof(JitContext, base), SIZE = offsetof(JitContext, size), PTR = offsetof(JitContext, ptr) };
+
+        struct Fixup {
+            size_t at;
+            int64_t target;
+        };
+
+        const JitHooks& hooks;
+        std::vector<Fixup> fixups;
+
+        void emit(std::initializer_list<uint8_t> list) { bytes.insert(bytes.end(), list); }
+
+        void emit32(uint32_t v) {
+            for (int i = 0; i < 4; i++) bytes.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        }
+
+        void emit64(uint64_t v) {
+            for (int i = 0; i < 8; i++) bytes.push_back(static_cast<uint8_t>(v >> (8 * i)));
+        }
+
+        // jmp/jcc rel32 на инструкцию байткода или служебную метку
+        void jump(uint8_t opcode, int64_t target) {
+            if (opcode != 0xE9) bytes.push_back(0x0F);
+            bytes.push_back(opcode);
+            fixups.push_back({bytes.size(), target});
+            emit32(0);
+        }
+
+        void prologue() {
+            emit({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57});
+            emit({0x48, 0x89, 0xFB});               // mov rbx, rdi
+            reload();
+        }
+
+        void reload() {
+            emit({0x4C, 0x8B, 0x63, PTR});          // mov r12, [rbx+ptr]
+            emit({0x4C, 0x8B, 0x6B, BASE});         // mov r13, [rbx+base]
+            emit({0x4C, 0x8B, 0x73, SIZE});         // mov r14, [rbx+size]
+        }
+
+        void call(const void* fn) {
+            emit({0x48, 0x89, 0xDF});               // mov rdi, rbx
+            emit({0x48, 0xB8});                     // mov rax, fn
+            emit64(reinterpret_cast<uint64_t>(fn));
+            emit({0xFF, 0xD0});                     // call rax
+            reload();
+            emit({0x85, 0xC0});                     // test eax, eax
+            jump(0x85, EPILOGUE);                   // jnz epilogue
+        }
+
+        void cmp_cell_zero() {
+            emit({0x43, 0x83, 0x7C, 0xA5, 0x00, 0x00});
+        }
+
+        void add_cell(int32_t value) {
+            emit({0x43, 0x81, 0x44, 0xA5, 0x00});
+            emit32(static_cast<uint32_t>(value));
+        }
+
+        void check_lowest(int32_t lowest) {
+            if (lowest >= 0) return;
+            // lowest > INT32_MIN проверяется в instruction()
+            emit({0x49, 0x81, 0xFC});               // cmp r12, -lowest
+            emit32(static_cast<uint32_t>(-static_cast<int64_t>(lowest)));
+            jump(0x82, UNDERFLOW);                  // jb underflow
+        }
+
+        // Индекс в rsi должен быть меньше ёмкости ленты
+        void check_rsi() {
+            emit({0x4C, 0x39, 0xF6});               // cmp rsi, r14
+            jump(0x83, OVERFLOW);                   // jae overflow
+        }
+
+        void slow(uint32_t op) {
+            emit({0x4C, 0x89, 0x63, PTR});          // mov [rbx+ptr], r12
+            emit({0xBE});                           // mov esi, op
+            emit32(op);
+            call(reinterpret_cast<const void*>(hooks.slow));
+        }
+
+        // Указатель меняется только после проверок, как в интерпретаторе
+        void move(int32_t offset, int32_t lowest) {
+            check_lowest(lowest);
+            if (offset == 0) return;
+            if (offset > 0) {
+                emit({0x49, 0x8D, 0xB4, 0x24});     // lea rsi, [r12+offset]
+                emit32(static_cast<uint32_t>(offset));
+                check_rsi();
+                emit({0x49, 0x89, 0xF4});           // mov r12, rsi
+                return;
+            }
+            emit({0x49, 0x81, 0xC4});               // add r12, offset
+            emit32(static_cast<uint32_t>(offset));
+        }
+
+        bool instruction(const Instr& ins) {
+            if ((ins.op == MOVE || ins.op == LOOP_MUL) && ins.aux == INT32_MIN) return false;
+            switch (ins.op) {
+                case MOO:
+                    cmp_cell_zero();
+                    jump(0x84, ins.arg);
+                    break;
+                case moo:
+                    cmp_cell_zero();
+                    jump(0x85, ins.arg);
+                    break;
+                case LOOP_MUL:
+                    cmp_cell_zero();
+                    jump(0x84, ins.arg);
+                    check_lowest(ins.aux);
+                    break;
+                case MUL_ADD:
+                    if (ins.arg > INT32_MAX / 4 || ins.arg < INT32_MIN / 4) return false;
+                    if (ins.arg > 0) {
+                        emit({0x49, 0x8D, 0xB4, 0x24});     // lea rsi, [r12+offset]
+                        emit32(static_cast<uint32_t>(ins.arg));
+                        check_rsi();
+                    }
+                    emit({0x43, 0x8B, 0x44, 0xA5, 0x00});   // mov eax, [cell]
+                    emit({0x69, 0xC0});                     // imul eax, eax, factor
+                    emit32(static_cast<uint32_t>(ins.aux));
+                    emit({0x43, 0x01, 0x84, 0xA5});         // add [cell+offset*4], eax
+                    emit32(static_cast<uint32_t>(ins.arg) * 4u);
+                    break;
+                case ADD: add_cell(ins.arg); break;
+                case MoO: add_cell(1); break;
+                case MOo: add_cell(-1); break;
+                case OOO:
+                    emit({0x43, 0xC7, 0x44, 0xA5, 0x00});   // mov [cell], 0
+                    emit32(0);
+                    break;
+                case MOVE: move(ins.arg, ins.aux); break;
+                case moO: move(1, 0); break;
+                case mOo: move(-1, -1); break;
+                case mOO:
+                case Moo:
+                case OOM:
+                case oom:
+                case MMM:
+                    slow(ins.op);
+                    break;
+                case NOP: break;
+                case HALT:
+                    emit({0x31, 0xC0});                     // xor eax, eax
+                    jump(0xE9, EPILOGUE);
+                    break;
+                default:
+                    return false;
+            }
+            return true;
+        }
+    };
+#endif
+};
+
+}
+
+#endif
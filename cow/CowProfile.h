@@ -0,0 +1,77 @@
+#ifndef COW_PROFILE_H
+#define COW_PROFILE_H
+
+#include <vector>
+#include <ostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include "CowProgram.h"
+
+// Результат профилирующего запуска. Все массивы индексируются адресом
+// инструкции байткода; смещения в исходнике берутся из программы.
+struct CowProfile {
+    std::vector<uint64_t> counts;       // сколько раз выполнена инструкция
+    std::vector<uint64_t> loopNanos;    // время внутри цикла (по адресу MOO), вложенные циклы включены
+    std::chrono::nanoseconds elapsed{0};
+
+    void clear(size_t size) {
+        counts.assign(size, 0);
+        loopNanos.assign(size, 0);
+        elapsed = std::chrono::nanoseconds(0);
+    }
+
+    uint64_t total() const {
+        uint64_t sum = 0;
+        for (uint64_t c : counts) sum += c;
+        return sum;
+    }
+
+    // Число проходов тела цикла, начинающегося MOO по адресу pc
+    uint64_t iterations(const CowProgram& program, size_t pc) const {
+        const cow::Instr& instr = program.getCode()[pc];
+        return counts[static_cast<size_t>(instr.arg) - 1];
+    }
+
+    void report(std::ostream& out, const CowProgram& program, size_t top = 10) const {
+        const auto& code = program.getCode();
+        uint64_t executed = total();
+        double ms = std::chrono::duration<double, std::milli>(elapsed).count();
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+
+        out << "instructions: " << executed << "\n";
+        out << "time: " << std::fixed << std::setprecision(3) << ms << " ms\n";
+
+        out << "loops (offset: entries, iterations, time):\n";
+        for (size_t pc = 0; pc < code.size(); pc++) {
+            if (code[pc].op == cow::MOO && counts[pc] != 0) {
+                out << "  @" << program.getSourceOffset(pc) << ": " << counts[pc] << ", "
+                    << iterations(program, pc) << ", " << loopNanos[pc] / 1e6 << " ms\n";
+            } else if (code[pc].op == cow::LOOP_MUL && counts[pc] != 0) {
+                out << "  @" << program.getSourceOffset(pc) << ": " << counts[pc] << ", folded\n";
+            }
+        }
+
+        std::vector<size_t> order;
+        for (size_t pc = 0; pc < code.size(); pc++) {
+            if (counts[pc] != 0) order.push_back(pc);
+        }
+        top = std::min(top, order.size());
+        std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(top), order.end(),
+                          [this](size_t a, size_t b) { return counts[a] > counts[b]; });
+
+        out << "hot instructions (offset, op, count, share):\n";
+        for (size_t i = 0; i < top; i++) {
+            size_t pc = order[i];
+            out << "  @" << program.getSourceOffset(pc) << " " << cow::op_name(code[pc].op) << " "
+                << counts[pc] << " " << std::setprecision(1) << 100.0 * counts[pc] / executed << "%\n";
+            out << std::setprecision(3);
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef COW_PROGRAM_H
+#define COW_PROGRAM_H
+
+#include <vector>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "CowBytecode.h"
+#include "CowJit.h"
+
+enum class CowMode {
+    Basic,      // каждая инструкция исполняется отдельно
+    Optimized,  // свёртка серий и простых циклов
+    Jit         // машинный код x86-64, иначе Optimized
+};
+
+// Разобранная и скомпилированная программа. После создания не меняется,
+// поэтому один экземпляр можно исполнять из нескольких потоков сразу.
+class CowProgram {
+public:
+    explicit CowProgram(std::string_view source, CowMode mode = CowMode::Optimized) : mode(mode) {
+        std::vector<uint32_t> sourceOffsets;
+        std::vector<cow::OpCode> instructions = cow::parse(source, &sourceOffsets);
+        cow::Compiler compiler(instructions, mode != CowMode::Basic);
+        code = compiler.compile();
+
+        sourceOffsets.push_back(static_cast<uint32_t>(source.size()));
+        offsets.reserve(code.size());
+        for (uint32_t origin : compiler.getOrigins()) offsets.push_back(sourceOffsets[origin]);
+    }
+
+    // Уже скомпилированный байткод, например из кэша. Переходы должны быть
+    // разрешены, offsets - по одному смещению на инструкцию.
+    CowProgram(CowMode mode, std::vector<cow::Instr> code, std::vector<uint32_t> offsets)
+        : mode(mode), code(std::move(code)), offsets(std::move(offsets)) {}
+
+    CowProgram(const CowProgram&) = delete;
+    CowProgram& operator=(const CowProgram&) = delete;
+
+    CowMode getMode() const { return mode; }
+    const std::vector<cow::Instr>& getCode() const { return code; }
+
+    // Смещение в исходнике для каждой инструкции байткода
+    uint32_t getSourceOffset(size_t pc) const { return offsets[pc]; }
+    const std::vector<uint32_t>& getSourceOffsets() const { return offsets; }
+
+    // Машинный код собирается один раз при первом запросе.
+    // nullptr, если JIT на этой платформе недоступен.
+    const cow::JitCode* getJit(const cow::JitHooks& hooks) const {
+        if (mode != CowMode::Jit || !cow::JitCode::available()) return nullptr;
+        std::call_once(jit_once, [&] {
+            auto compiled = std::make_unique<cow::JitCode>(code, hooks);
+            if (compiled->valid()) jit = std::move(compiled);
+        });
+        return jit.get();
+    }
+
+private:
+    CowMode mode;
+    std::vector<cow::Instr> code;
+    std::vector<uint32_t> offsets;
+
+    mutable std::once_flag jit_once;
+    mutable std::unique_ptr<cow::JitCode> jit;
+};
+
+#endif
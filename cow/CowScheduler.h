@@ -0,0 +1,197 @@
+#ifndef COW_SCHEDULER_H
+#define COW_SCHEDULER_H
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "CowExecution.h"
+
+enum class CowTaskState {
+    Pending,
+    Finished,
+    Failed,         // исключение во время исполнения, текст в error
+    StepLimit       // исчерпан собственный лимит шагов задачи
+};
+
+struct CowTaskResult {
+    CowTaskState state = CowTaskState::Pending;
+    std::string output;
+    std::string error;
+    uint64_t steps = 0;
+};
+
+// Кооперативный планировщик: много исполнений COW на нескольких рабочих
+// потоках. Каждая задача получает квант в sliceSteps инструкций и встаёт в
+// конец общей очереди, так что бесконечная программа не занимает поток
+// навсегда, а только расходует свой лимит шагов. Завершённая задача
+// сразу освобождает ленту, буферы и потоки ввода-вывода, хранится только
+// её результат.
+class CowScheduler {
+public:
+    struct Options {
+        unsigned workers = std::max(1u, std::thread::hardware_concurrency());
+        size_t sliceSteps = 10000;
+        size_t tapeCells = size_t(1) << 20;
+    };
+
+    CowScheduler() : CowScheduler(Options()) {}
+
+    explicit CowScheduler(const Options& options) : options(options) {
+        // с нулевым квантом задача без лимита шагов не продвинулась бы никогда
+        if (options.sliceSteps == 0) throw std::invalid_argument("Scheduler slice must be at least one step");
+        if (options.workers == 0) throw std::invalid_argument("Scheduler needs at least one worker");
+        for (unsigned i = 0; i < options.workers; i++) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ~CowScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    CowScheduler(const CowScheduler&) = delete;
+    CowScheduler& operator=(const CowScheduler&) = delete;
+
+    // stepLimit == 0 - без ограничения
+    size_t submit(std::shared_ptr<const CowProgram> program, std::string input = "", uint64_t stepLimit = 0) {
+        auto task = std::make_unique<Task>(std::move(program), std::move(input), stepLimit, options.tapeCells);
+        task->run->execution.start(*task->program);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t id = tasks.size();
+        task->id = id;
+        ready.push_back(task.get());
+        tasks.push_back(std::move(task));
+        pending++;
+        wake.notify_one();
+        return id;
+    }
+
+    // Ждёт завершения всех поставленных задач
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return pending == 0; });
+    }
+
+    CowTaskResult result(size_t id) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tasks.at(id)->result;
+    }
+
+    // Число задач, которые ещё держат ленту и буферы исполнения
+    size_t active() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return static_cast<size_t>(std::count_if(tasks.begin(), tasks.end(),
+                                                 [](const std::unique_ptr<Task>& t) { return t->run != nullptr; }));
+    }
+
+private:
+    // Исполнение с его потоками; живёт, пока задача не завершена
+    struct Run {
+        std::istringstream in;
+        std::ostringstream out;
+        CowExecution execution;
+
+        Run(std::string input, size_t tapeCells) : in(std::move(input)), execution(in, out, tapeCells) {}
+    };
+
+    struct Task {
+        size_t id = 0;
+        std::shared_ptr<const CowProgram> program;
+        std::unique_ptr<Run> run;
+        uint64_t stepLimit;
+        CowTaskResult result;
+
+        Task(std::shared_ptr<const CowProgram> program, std::string input, uint64_t stepLimit, size_t tapeCells)
+            : program(std::move(program)), run(std::make_unique<Run>(std::move(input), tapeCells)),
+              stepLimit(stepLimit) {}
+    };
+
+    Options options;
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Task>> tasks;
+    std::deque<Task*> ready;
+    size_t pending = 0;
+    bool stopping = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+
+    void work() {
+        for (;;) {
+            Task* task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !ready.empty(); });
+                if (stopping) return;
+                task = ready.front();
+                ready.pop_front();
+            }
+
+            std::string error;
+            CowTaskState state = slice(*task, error);
+
+            if (state == CowTaskState::Pending) {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready.push_back(task);
+                wake.notify_one();
+                continue;
+            }
+
+            CowTaskResult done;
+            done.state = state;
+            done.error = std::move(error);
+            done.output = task->run->out.str();
+            done.steps = task->run->execution.getSteps();
+
+            // Исполнение забирается под блокировкой, а освобождается (munmap
+            // ленты) вне её, но до того, как wait() увидит задачу завершённой
+            std::unique_ptr<Run> finished;
+            std::shared_ptr<const CowProgram> program;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished = std::move(task->run);
+                program = std::move(task->program);
+                task->result = std::move(done);
+            }
+            finished.reset();
+            program.reset();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) idle.notify_all();
+        }
+    }
+
+    // Один квант задачи; Pending - задача ещё не завершена
+    CowTaskState slice(Task& task, std::string& error) {
+        size_t budget = options.sliceSteps;
+        CowExecution& execution = task.run->execution;
+        if (task.stepLimit) {
+            uint64_t used = execution.getSteps();
+            if (used >= task.stepLimit) return CowTaskState::StepLimit;
+            budget = static_cast<size_t>(std::min<uint64_t>(budget, task.stepLimit - used));
+        }
+        try {
+            if (execution.resume(budget) == CowStatus::Finished) return CowTaskState::Finished;
+        } catch (const std::exception& e) {
+            error = e.what();
+            return CowTaskState::Failed;
+        }
+        return CowTaskState::Pending;
+    }
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef COW_TAPE_H
+#define COW_TAPE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define COW_TAPE_MMAP 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Лента фиксированной ёмкости. Диапазон резервируется в виртуальной памяти
+// целиком, страницы выделяет ядро при первом обращении, поэтому сдвиг
+// указателя не требует ни перевыделения, ни копирования. Выход за ленту
+// ловят проверки границ при каждом сдвиге указателя; защитная страница
+// без доступа за концом ленты - только страховка на случай ошибки в них,
+// до неё исполнение доходить не должно.
+template <typename Cell>
+class BasicCowTape {
+public:
+    static constexpr size_t kDefaultCells = size_t(1) << 26;
+
+    explicit BasicCowTape(size_t cells = kDefaultCells) : cells(cells) {
+        reserve();
+    }
+
+    ~BasicCowTape() { release(); }
+
+    BasicCowTape(const BasicCowTape&) = delete;
+    BasicCowTape& operator=(const BasicCowTape&) = delete;
+
+    Cell* data() { return base; }
+    const Cell* data() const { return base; }
+    size_t size() const { return cells; }
+
+    Cell& operator[](size_t index) { return base[index]; }
+    Cell operator[](size_t index) const { return base[index]; }
+
+    // Обнуляет ленту, возвращая занятые страницы системе
+    void clear() {
+        release();
+        reserve();
+    }
+
+private:
+    size_t cells;
+    Cell* base = nullptr;
+    size_t mapped = 0;
+
+#ifdef COW_TAPE_MMAP
+    void reserve() {
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t bytes = (cells * sizeof(Cell) + page - 1) / page * page;
+        void* mem = mmap(nullptr, bytes + page, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mem == MAP_FAILED) throw std::bad_alloc();
+        if (mprotect(static_cast<char*>(mem) + bytes, page, PROT_NONE) != 0) {
+            munmap(mem, bytes + page);
+            throw std::bad_alloc();
+        }
+        base = static_cast<Cell*>(mem);
+        mapped = bytes + page;
+    }
+
+    void release() {
+        if (base) munmap(base, mapped);
+        base = nullptr;
+    }
+#else
+    void reserve() {
+        base = static_cast<Cell*>(std::calloc(cells, sizeof(Cell)));
+        if (!base) throw std::bad_alloc();
+    }
+
+    void release() {
+        std::free(base);
+        base = nullptr;
+    }
+#endif
+};
+
+using CowTape = BasicCowTape<int32_t>;
+
+#endif
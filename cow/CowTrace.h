@@ -0,0 +1,177 @@
+#ifndef COW_TRACE_H
+#define COW_TRACE_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include "CowProgram.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace cow {
+
+// Состояние перед выполнением инструкции pc
+struct TraceEntry {
+    uint32_t pc;
+    uint32_t op;
+    uint64_t ptr;
+    int64_t cell;
+};
+
+// Заголовок сырого дампа; за ним capacity записей кольца в порядке хранения
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t mode;
+    uint64_t sourceHash;    // FNV-1a, как у кэша байткода
+    uint64_t capacity;
+    uint64_t head;          // всего записей с начала исполнения
+};
+
+constexpr char kTraceMagic[8] = {'C', 'O', 'W', 'T', 'R', '\0', '\0', '\0'};
+constexpr uint32_t kTraceVersion = 1;
+
+// Кольцевой буфер последних шагов исполнения. Пишет один поток
+// (исполнение), читать можно в любой момент из другого потока или из
+// обработчика сигнала: head публикуется после записи элемента, а
+// dump_raw() использует только write(2).
+class TraceRing {
+public:
+    static constexpr size_t kMaxCapacity = size_t(1) << 30;
+
+    // capacity округляется вверх до степени двойки, не больше kMaxCapacity
+    explicit TraceRing(size_t capacity = 4096) {
+        if (capacity > kMaxCapacity) throw std::length_error("Trace is too long");
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        entries.reset(new TraceEntry[size]());
+        mask = size - 1;
+    }
+
+    TraceRing(const TraceRing&) = delete;
+    TraceRing& operator=(const TraceRing&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+    uint64_t total() const { return head.load(std::memory_order_acquire); }
+
+    void clear() { head.store(0, std::memory_order_release); }
+
+    void record(uint32_t pc, uint32_t op, uint64_t ptr, int64_t cell) {
+        uint64_t at = head.load(std::memory_order_relaxed);
+        entries[at & mask] = TraceEntry{pc, op, ptr, cell};
+        head.store(at + 1, std::memory_order_release);
+    }
+
+    // Сохранённые записи от старой к новой
+    std::vector<TraceEntry> snapshot() const {
+        uint64_t end = total();
+        uint64_t begin = end > capacity() ? end - capacity() : 0;
+        std::vector<TraceEntry> result;
+        result.reserve(static_cast<size_t>(end - begin));
+        for (uint64_t i = begin; i < end; i++) result.push_back(entries[i & mask]);
+        return result;
+    }
+
+    // Что записать в заголовок дампа: режим программы и хэш её исходника
+    void describe(CowMode mode, uint64_t sourceHash) {
+        this->mode = static_cast<uint32_t>(mode);
+        this->sourceHash = sourceHash;
+    }
+
+    // Безопасно для обработчика сигнала
+    bool dump_raw(int fd) const {
+#if defined(__unix__) || defined(__APPLE__)
+        TraceHeader header;
+        std::memcpy(header.magic, kTraceMagic, sizeof(kTraceMagic));
+        header.version = kTraceVersion;
+        header.mode = mode;
+        header.sourceHash = sourceHash;
+        header.capacity = capacity();
+        header.head = total();
+        return write_all(fd, &header, sizeof(header))
+            && write_all(fd, entries.get(), capacity() * sizeof(TraceEntry));
+#else
+        (void)fd;
+        return false;
+#endif
+    }
+
+private:
+    std::unique_ptr<TraceEntry[]> entries;
+    size_t mask;
+    std::atomic<uint64_t> head{0};
+    uint32_t mode = 0;
+    uint64_t sourceHash = 0;
+
+#if defined(__unix__) || defined(__APPLE__)
+    static bool write_all(int fd, const void* data, size_t size) {
+        const char* at = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = ::write(fd, at, size);
+            if (n <= 0) return false;
+            at += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+#endif
+};
+
+// Разбор сырого дампа; false, если это не дамп трассы
+inline bool parse_trace(std::string_view data, TraceHeader& header, std::vector<TraceEntry>& entries) {
+    if (data.size() < sizeof(header)) return false;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, kTraceMagic, sizeof(kTraceMagic)) != 0 || header.version != kTraceVersion) {
+        return false;
+    }
+    if (header.capacity == 0 || (header.capacity & (header.capacity - 1)) != 0
+        || data.size() != sizeof(header) + header.capacity * sizeof(TraceEntry)) {
+        return false;
+    }
+
+    const char* stored = data.data() + sizeof(header);
+    uint64_t end = header.head;
+    uint64_t begin = end > header.capacity ? end - header.capacity : 0;
+    entries.clear();
+    for (uint64_t i = begin; i < end; i++) {
+        TraceEntry entry;
+        std::memcpy(&entry, stored + (i & (header.capacity - 1)) * sizeof(TraceEntry), sizeof(entry));
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+// Печатает записи с позициями в исходнике: смещение и строка:столбец.
+// first - порядковый номер первой записи от начала исполнения.
+inline void decode_trace(std::ostream& out, const std::vector<TraceEntry>& entries, uint64_t first,
+                         const CowProgram& program, std::string_view source) {
+    std::vector<size_t> lines{0};
+    for (size_t i = 0; i < source.size(); i++) {
+        if (source[i] == '\n') lines.push_back(i + 1);
+    }
+
+    const auto& code = program.getCode();
+    for (size_t i = 0; i < entries.size(); i++) {
+        const TraceEntry& e = entries[i];
+        out << "#" << first + i << " pc " << e.pc << " " << op_name(e.op);
+        if (e.pc < code.size()) {
+            size_t offset = program.getSourceOffset(e.pc);
+            size_t line = static_cast<size_t>(std::upper_bound(lines.begin(), lines.end(), offset) - lines.begin());
+            out << " @" << offset << " (" << line << ":" << offset - lines[line - 1] + 1 << ")";
+        }
+        out << " ptr " << e.ptr << " cell " << e.cell << "\n";
+    }
+}
+
+}
+
+#endif
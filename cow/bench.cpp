@@ -0,0 +1,240 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include "CowExecution.h"
+#include "MappedFile.h"
+#include "CommandLine.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef COW_BENCH_DIR
+#define COW_BENCH_DIR "bench"
+#endif
+
+// Эталонные программы для сравнения версий интерпретатора. Каждая пара
+// (программа, режим) меряется в отдельном дочернем процессе, чтобы пиковая
+// память (ru_maxrss из wait4) относилась только к ней.
+
+void printUsage(const char* progName) {
+    std::cout << "COW Benchmark\n";
+    std::cout << "-------------\n";
+    std::cout << "Usage:\n";
+    std::cout << "  " << progName << " [--csv] [--time SECONDS] [--repeat N] [program...]\n\n";
+    std::cout << "Description:\n";
+    std::cout << "  Runs the reference programs from " COW_BENCH_DIR " in every execution mode and\n";
+    std::cout << "  reports parse time, run time, instructions per second and peak memory.\n";
+    std::cout << "  Instructions are counted as executed source instructions (Basic mode), so\n";
+    std::cout << "  the rate is comparable across modes.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --csv               Machine-readable output.\n";
+    std::cout << "  --time SECONDS      Minimum measuring time per run (default: 0.2).\n";
+    std::cout << "  --repeat N          Runs per program and mode; the fastest is reported (default: 3).\n";
+    std::cout << "  program...          Names from the corpus (default: all).\n";
+}
+
+struct BenchProgram {
+    const char* name;
+    const char* file;
+    std::string input;
+};
+
+struct Sample {
+    double parseSeconds = 0;
+    double runSeconds = 0;
+    long peakKb = 0;
+    bool ok = false;
+};
+
+// Вывод программы не нужен, считаются только байты
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+static std::string echoInput() {
+    std::string text;
+    text.reserve(1 << 20);
+    for (size_t i = 0; text.size() < (1 << 20); i++) text += (i % 64 == 63) ? '\n' : static_cast<char>('a' + i % 26);
+    return text;
+}
+
+static double seconds(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+// Повторяет f, пока не наберётся minTime; время одного вызова
+template <typename F>
+static double measure(double minTime, F f) {
+    auto begin = std::chrono::steady_clock::now();
+    size_t calls = 0;
+    do {
+        f();
+        calls++;
+    } while (seconds(std::chrono::steady_clock::now() - begin) < minTime);
+    return seconds(std::chrono::steady_clock::now() - begin) / static_cast<double>(calls);
+}
+
+static Sample measureInChild(const std::string& source, const std::string& input, CowMode mode, double minTime) {
+    int fds[2];
+    Sample sample;
+    if (pipe(fds) != 0) return sample;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        double result[2] = {0, 0};
+        try {
+            result[0] = measure(minTime, [&] { CowProgram program(source, mode); });
+            CowProgram program(source, mode);
+            NullBuffer sink;
+            std::ostream out(&sink);
+            result[1] = measure(minTime, [&] {
+                std::istringstream in(input);
+                CowExecution execution(in, out);
+                execution.run(program);
+            });
+        } catch (const std::exception& e) {
+            std::cerr << "error: " << e.what() << "\n";
+            _exit(1);
+        }
+        ssize_t written = write(fds[1], result, sizeof(result));
+        _exit(written == static_cast<ssize_t>(sizeof(result)) ? 0 : 1);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        return sample;
+    }
+
+    double result[2];
+    ssize_t got = read(fds[0], result, sizeof(result));
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid) return sample;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || got != static_cast<ssize_t>(sizeof(result))) return sample;
+
+    sample.parseSeconds = result[0];
+    sample.runSeconds = result[1];
+    sample.peakKb = usage.ru_maxrss;
+#ifdef __APPLE__
+    sample.peakKb /= 1024;  // там байты
+#endif
+    sample.ok = true;
+    return sample;
+}
+
+// Число исходных инструкций, выполненных программой
+static uint64_t countInstructions(const std::string& source, const std::string& input) {
+    CowProgram program(source, CowMode::Basic);
+    std::istringstream in(input);
+    NullBuffer sink;
+    std::ostream out(&sink);
+    CowExecution execution(in, out);
+    CowProfile profile;
+    execution.runProfiled(program, profile);
+    return profile.total() - 1;     // без HALT
+}
+
+int main(int argc, char* argv[]) {
+    bool csv = false;
+    double minTime = 0.2;
+    int repeat = 3;
+    std::vector<std::string> only;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--csv") csv = true;
+        else if (arg == "--time") {
+            if (i + 1 >= argc || !tppl::parse_seconds(argv[++i], minTime)) {
+                std::cerr << "Error: --time expects a positive number of seconds\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--repeat") {
+            unsigned long long runs = 0;
+            if (i + 1 >= argc || !tppl::parse_number(argv[++i], 1000000, runs) || runs == 0) {
+                std::cerr << "Error: --repeat expects a number from 1 to 1000000\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+            repeat = static_cast<int>(runs);
+        }
+        else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else only.push_back(arg);
+    }
+
+    std::vector<BenchProgram> corpus = {
+        {"hello", "hello.cow", ""},
+        {"fibonacci", "fibonacci.cow", ""},
+        {"nested", "nested.cow", ""},
+        {"echo", "echo.cow", echoInput()},
+        {"indirect", "indirect.cow", ""},
+    };
+    const std::pair<CowMode, const char*> modes[] = {
+        {CowMode::Basic, "basic"}, {CowMode::Optimized, "optimized"}, {CowMode::Jit, "jit"}
+    };
+
+    if (csv) std::cout << "program,mode,instructions,parse_us,run_ms,minstr_per_s,peak_kb\n";
+    else std::printf("%-10s %-10s %12s %10s %10s %12s %10s\n",
+                     "program", "mode", "instr", "parse us", "run ms", "Minstr/s", "peak KB");
+
+    int failures = 0;
+    for (const BenchProgram& bench : corpus) {
+        if (!only.empty() && std::find(only.begin(), only.end(), bench.name) == only.end()) continue;
+
+        tppl::MappedFile file(std::string(COW_BENCH_DIR) + "/" + bench.file);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file '" << COW_BENCH_DIR << "/" << bench.file << "'\n";
+            return 1;
+        }
+        std::string source(file.view());
+        uint64_t instructions = countInstructions(source, bench.input);
+
+        for (const auto& mode : modes) {
+            Sample best;
+            for (int r = 0; r < repeat; r++) {
+                Sample s = measureInChild(source, bench.input, mode.first, minTime);
+                if (!s.ok) continue;
+                if (!best.ok) {
+                    best = s;
+                    continue;
+                }
+                best.parseSeconds = std::min(best.parseSeconds, s.parseSeconds);
+                best.runSeconds = std::min(best.runSeconds, s.runSeconds);
+                best.peakKb = std::max(best.peakKb, s.peakKb);
+            }
+            if (!best.ok) {
+                std::cerr << "Error: " << bench.name << " failed in " << mode.second << " mode\n";
+                failures++;
+                continue;
+            }
+
+            double rate = static_cast<double>(instructions) / best.runSeconds / 1e6;
+            if (csv) {
+                std::printf("%s,%s,%llu,%.3f,%.3f,%.1f,%ld\n", bench.name, mode.second,
+                            static_cast<unsigned long long>(instructions), best.parseSeconds * 1e6,
+                            best.runSeconds * 1e3, rate, best.peakKb);
+            } else {
+                std::printf("%-10s %-10s %12llu %10.3f %10.3f %12.1f %10ld\n", bench.name, mode.second,
+                            static_cast<unsigned long long>(instructions), best.parseSeconds * 1e6,
+                            best.runSeconds * 1e3, rate, best.peakKb);
+            }
+            std::fflush(stdout);
+        }
+    }
+    return failures ? 1 : 0;
+}
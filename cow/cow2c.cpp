@@ -0,0 +1,77 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdint>
+#include "CowCodegen.h"
+#include "MappedFile.h"
+#include "CommandLine.h"
+
+void printUsage(const char* progName) {
+    std::cout << "COW to C compiler\n";
+    std::cout << "-----------------\n";
+    std::cout << "Usage:\n";
+    std::cout << "  " << progName << " [--basic] [--cell TYPE] [--tape CELLS] <path_to_cow_file> [-o <output.c>]\n\n";
+    std::cout << "Description:\n";
+    std::cout << "  Translates a COW program into an equivalent C source file. Build it with the\n";
+    std::cout << "  system compiler, e.g. 'cc -O2 -o prog prog.c'. The binary behaves like\n";
+    std::cout << "  running the program with the cow interpreter.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --basic             Translate every instruction separately, without folding\n";
+    std::cout << "                      runs and simple loops.\n";
+    std::cout << "  --cell TYPE         Tape cell type: int8, uint8, int32 (default) or int64.\n";
+    std::cout << "  --tape CELLS        Tape capacity in cells, at least 1.\n";
+    std::cout << "  -o <output.c>       Output file (default: standard output).\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string filePath, outputPath;
+    CowMode mode = CowMode::Optimized;
+    cow::CodegenOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--basic") mode = CowMode::Basic;
+        else if (arg == "--cell" && i + 1 < argc) options.cell = argv[++i];
+        else if (arg == "--tape" && i + 1 < argc) {
+            unsigned long long cells = 0;
+            if (!tppl::parse_number(argv[++i], SIZE_MAX, cells) || cells == 0) {
+                std::cerr << "Error: Invalid tape size '" << argv[i] << "'\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+            options.tapeCells = static_cast<size_t>(cells);
+        }
+        else if (arg == "-o" && i + 1 < argc) outputPath = argv[++i];
+        else filePath = arg;
+    }
+
+    if (filePath.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    tppl::MappedFile file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file '" << filePath << "'\n";
+        return 1;
+    }
+
+    try {
+        CowProgram program(file.view(), mode);
+        if (outputPath.empty()) {
+            cow::emit_c(program, std::cout, options);
+        } else {
+            std::ofstream out(outputPath);
+            if (!out.is_open()) {
+                std::cerr << "Error: Could not open file '" << outputPath << "'\n";
+                return 1;
+            }
+            cow::emit_c(program, out, options);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
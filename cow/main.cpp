@@ -2,55 +2,358 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <cstdlib>
+#include <climits>
+#include <cstdint>
 #include "CowInterpreter.h"
+#include "OrderedRun.h"
+#include "MappedFile.h"
+#include "CommandLine.h"
+#include "CowCache.h"
+#include "CowTrace.h"
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
 
 void printUsage(const char* progName) {
     std::cout << "COW Language Interpreter\n";
     std::cout << "------------------------\n";
     std::cout << "Usage:\n";
-    std::cout << "  " << progName << " <path_to_cow_file>\n\n";
+    std::cout << "  " << progName << " [--jit] [--cell TYPE] <path_to_cow_file>\n";
+    std::cout << "  " << progName << " --profile <path_to_cow_file>\n";
+    std::cout << "  " << progName << " [--jit] --trace N [--trace-file PATH] <path_to_cow_file>\n";
+    std::cout << "  " << progName << " --decode-trace <trace_file> <path_to_cow_file>\n";
+    std::cout << "  " << progName << " [--jit] [-j N] --batch <cow_file>...\n";
+    std::cout << "  " << progName << " [--jit] [-j N] --inputs <path_to_cow_file> <input_file>...\n\n";
     std::cout << "Description:\n";
     std::cout << "  This utility executes programs written in the COW esoteric programming language.\n";
     std::cout << "  The file extension is typically .cow, but any text file is accepted.\n\n";
     std::cout << "Options:\n";
-    std::cout << "  <path_to_cow_file>  Absolute or relative path to the source code file.\n\n";
+    std::cout << "  <path_to_cow_file>  Absolute or relative path to the source code file.\n";
+    std::cout << "  --jit               Compile the program to x86-64 machine code before running\n";
+    std::cout << "                      (falls back to the interpreter on other hosts).\n";
+    std::cout << "  --profile           Count executed instructions and loop iterations and print\n";
+    std::cout << "                      a report annotated with source offsets to stderr.\n";
+    std::cout << "  --trace N           Keep the last N executed instructions in memory (N from 1\n";
+    std::cout << "                      to 1073741824). They are printed to stderr on a runtime\n";
+    std::cout << "                      error and written to the trace file on SIGUSR1, SIGINT\n";
+    std::cout << "                      or SIGTERM.\n";
+    std::cout << "  --trace-file PATH   Where signal dumps go (default: cow-trace.bin).\n";
+    std::cout << "  --decode-trace      Print a trace file with source positions of its program.\n";
+    std::cout << "  --cell TYPE         Tape cell type: int8, uint8, int32 (default) or int64.\n";
+    std::cout << "                      Cell arithmetic wraps around at the chosen width.\n";
+    std::cout << "  --cache DIR         Keep compiled bytecode in DIR and reuse it while the source\n";
+    std::cout << "                      is unchanged (default: $COW_CACHE_DIR, if set).\n";
+    std::cout << "  --batch             Run every listed program with empty input.\n";
+    std::cout << "  --inputs            Compile the program once and run it against every input file.\n";
+    std::cout << "  -j N                Number of worker threads for batch runs (default: all cores).\n";
+    std::cout << "                      Batch results are printed in order, each after a\n";
+    std::cout << "                      '==> name <==' header.\n\n";
+    std::cout << "Limits:\n";
+    std::cout << "  The tape holds 67108864 cells. Moving the pointer past the last one stops the\n";
+    std::cout << "  program with a 'Memory Overflow' error, before the first - 'Memory Underflow'.\n\n";
     std::cout << "Example:\n";
     std::cout << "  " << progName << " hello_world.cow\n";
 }
 
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        printUsage(argv[0]);
+struct BatchResult {
+    std::string output;
+    std::string error;
+};
+
+// Параметры командной строки
+struct Options {
+    CowMode mode = CowMode::Optimized;
+    std::string filePath;
+    std::vector<std::string> batchFiles;
+    bool batch = false, inputs = false, profile = false;
+    unsigned threads = std::thread::hardware_concurrency();
+    std::string cacheDir;
+    size_t traceEntries = 0;
+    std::string traceFile = "cow-trace.bin";
+};
+
+// Кольцо трассы и путь дампа для обработчика сигналов
+static cow::TraceRing* traceRing = nullptr;
+static const char* tracePath = nullptr;
+
+extern "C" void dumpTraceOnSignal(int sig) {
+    int fd = ::open(tracePath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        traceRing->dump_raw(fd);
+        ::close(fd);
+    }
+    if (sig != SIGUSR1) {
+        std::signal(sig, SIG_DFL);
+        std::raise(sig);
+    }
+}
+
+static int decodeTrace(const std::string& tracePath, const std::string& programPath) {
+    tppl::MappedFile dump(tracePath);
+    tppl::MappedFile file(programPath);
+    if (!dump.is_open() || !file.is_open()) {
+        std::cerr << "Error: Could not open file '" << (dump.is_open() ? programPath : tracePath) << "'\n";
+        return 1;
+    }
+
+    cow::TraceHeader header;
+    std::vector<cow::TraceEntry> entries;
+    if (!cow::parse_trace(dump.view(), header, entries)) {
+        std::cerr << "Error: '" << tracePath << "' is not a COW trace\n";
         return 1;
     }
+    if (header.sourceHash != cow::hash_source(file.view())) {
+        std::cerr << "Warning: the trace was recorded for a different version of '" << programPath << "'\n";
+    }
+    try {
+        CowProgram program(file.view(), static_cast<CowMode>(header.mode));
+        cow::decode_trace(std::cout, entries, header.head - entries.size(), program, file.view());
+    } catch (const std::exception& e) {
+        std::cerr << "runtime error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Через кэш байткода, если он задан
+static std::shared_ptr<const CowProgram> compile(std::string_view source, CowMode mode, cow::BytecodeCache* cache) {
+    if (cache) return cache->load(source, mode);
+    return std::make_shared<const CowProgram>(source, mode);
+}
+
+// Один запуск пакета: программа (уже скомпилированная или путь к исходнику) и путь к вводу
+template <typename Cell>
+static BatchResult runJob(const std::shared_ptr<const CowProgram>& shared, const std::string& programPath,
+                          const std::string& inputPath, CowMode mode, cow::BytecodeCache* cache) {
+    BatchResult result;
+    std::ostringstream out;
+    try {
+        std::shared_ptr<const CowProgram> program = shared;
+        if (!program) {
+            tppl::MappedFile file(programPath);
+            if (!file.is_open()) throw std::runtime_error("Could not open file '" + programPath + "'");
+            program = compile(file.view(), mode, cache);
+        }
+
+        std::ifstream inputFile;
+        std::istringstream empty;
+        std::istream* in = &empty;
+        if (!inputPath.empty()) {
+            inputFile.open(inputPath, std::ios::binary);
+            if (!inputFile.is_open()) throw std::runtime_error("Could not open file '" + inputPath + "'");
+            in = &inputFile;
+        }
+
+        BasicCowExecution<Cell> execution(*in, out);
+        execution.run(*program);
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    result.output = out.str();
+    return result;
+}
+
+template <typename Cell>
+static int runBatch(const std::vector<std::string>& names, std::shared_ptr<const CowProgram> program,
+                    const std::string& programPath, CowMode mode, unsigned threads, cow::BytecodeCache* cache) {
+    bool failed = false;
+    tppl::run_ordered<BatchResult>(names.size(), threads,
+        [&](size_t i) {
+            return program ? runJob<Cell>(program, programPath, names[i], mode, cache)
+                           : runJob<Cell>(nullptr, names[i], "", mode, cache);
+        },
+        [&](size_t i, BatchResult& result) {
+            std::cout << "==> " << names[i] << " <==\n" << result.output << "\n";
+            if (!result.error.empty()) {
+                std::cout << "runtime error: " << result.error << "\n";
+                failed = true;
+            }
+            std::cout.flush();
+        });
+    return failed ? 1 : 0;
+}
+
+template <typename Cell>
+static int run(const Options& options, const char* progName) {
+    CowMode mode = options.mode;
+    const std::string& filePath = options.filePath;
+    std::vector<std::string> batchFiles = options.batchFiles;
+    unsigned threads = options.threads;
+
+    std::unique_ptr<cow::BytecodeCache> cacheStorage;
+    if (!options.cacheDir.empty()) cacheStorage = std::make_unique<cow::BytecodeCache>(options.cacheDir);
+    cow::BytecodeCache* cache = cacheStorage.get();
+
+    if (options.batch) {
+        if (!filePath.empty()) batchFiles.insert(batchFiles.begin(), filePath);
+        if (batchFiles.empty()) {
+            printUsage(progName);
+            return 1;
+        }
+        std::ios::sync_with_stdio(false);
+        return runBatch<Cell>(batchFiles, nullptr, "", mode, threads, cache);
+    }
 
-    std::string filePath = argv[1];
+    if (filePath.empty()) {
+        printUsage(progName);
+        return 1;
+    }
 
-    std::ifstream file(filePath);
+    tppl::MappedFile file(filePath);
     if (!file.is_open()) {
         std::cerr << "Error: Could not open file '" << filePath << "'\n";
         return 1;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string sourceCode = buffer.str();
-    file.close();
+    std::string_view sourceCode = file.view();
+
+    if (options.inputs) {
+        std::shared_ptr<const CowProgram> program;
+        try {
+            program = compile(sourceCode, mode, cache);
+        } catch (const std::exception& e) {
+            std::cerr << "runtime error: " << e.what() << std::endl;
+            return 1;
+        }
+        std::ios::sync_with_stdio(false);
+        return runBatch<Cell>(batchFiles, program, filePath, mode, threads, cache);
+    }
 
     if (sourceCode.empty()) {
         std::cerr << "Warning: The source file is empty.\n";
         return 0;
     }
 
+    std::ios::sync_with_stdio(false);
+
+    if (options.profile) {
+        CowProfile report;
+        try {
+            std::shared_ptr<const CowProgram> compiled =
+                compile(sourceCode, mode == CowMode::Jit ? CowMode::Optimized : mode, cache);
+            const CowProgram& program = *compiled;
+            BasicCowExecution<Cell> execution;
+            try {
+                execution.runProfiled(program, report);
+                std::cout << std::endl;
+            } catch (const std::exception& e) {
+                std::cout.flush();
+                std::cerr << "\nruntime error: " << e.what() << std::endl;
+                report.report(std::cerr, program);
+                return 1;
+            }
+            report.report(std::cerr, program);
+        } catch (const std::exception& e) {
+            std::cerr << "runtime error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (options.traceEntries) {
+        std::shared_ptr<const CowProgram> program;
+        try {
+            program = compile(sourceCode, mode == CowMode::Jit ? CowMode::Optimized : mode, cache);
+        } catch (const std::exception& e) {
+            std::cerr << "runtime error: " << e.what() << std::endl;
+            return 1;
+        }
+
+        std::unique_ptr<cow::TraceRing> storage;
+        try {
+            storage = std::make_unique<cow::TraceRing>(options.traceEntries);
+        } catch (const std::exception&) {
+            std::cerr << "Error: Cannot keep a trace of " << options.traceEntries << " instructions\n";
+            printUsage(progName);
+            return 1;
+        }
+        cow::TraceRing& ring = *storage;
+        ring.describe(program->getMode(), cow::hash_source(sourceCode));
+        traceRing = &ring;
+        tracePath = options.traceFile.c_str();
+        for (int sig : {SIGUSR1, SIGINT, SIGTERM}) std::signal(sig, dumpTraceOnSignal);
+
+        BasicCowExecution<Cell> execution;
+        execution.setTrace(&ring);
+        try {
+            execution.run(*program);
+            std::cout << std::endl;
+        } catch (const std::exception& e) {
+            std::cout.flush();
+            std::cerr << "\nruntime error: " << e.what() << std::endl;
+            std::vector<cow::TraceEntry> entries = ring.snapshot();
+            std::cerr << "last " << entries.size() << " instructions:\n";
+            cow::decode_trace(std::cerr, entries, ring.total() - entries.size(), *program, sourceCode);
+            return 1;
+        }
+        return 0;
+    }
+
     try {
-        CowInterpreter interpreter; 
-        interpreter.run(sourceCode);
-        
+        BasicCowInterpreter<Cell> interpreter;
+        interpreter.setMode(mode);
+        if (cache) interpreter.run(*cache->load(sourceCode, mode));
+        else interpreter.run(sourceCode);
+
         std::cout << std::endl;
     } catch (const std::exception& e) {
+        std::cout.flush();
         std::cerr << "\nruntime error: " << e.what() << std::endl;
         return 1;
     }
 
     return 0;
 }
+
+int main(int argc, char* argv[]) {
+    Options options;
+    std::string cell = "int32";
+    if (const char* dir = std::getenv("COW_CACHE_DIR")) options.cacheDir = dir;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--jit") options.mode = CowMode::Jit;
+        else if (arg == "--profile") options.profile = true;
+        else if (arg == "--batch") options.batch = true;
+        else if (arg == "--inputs") options.inputs = true;
+        else if (arg == "--cell" && i + 1 < argc) cell = argv[++i];
+        else if (arg == "--cache" && i + 1 < argc) options.cacheDir = argv[++i];
+        else if (arg == "--trace" && i + 1 < argc) {
+            unsigned long long entries = 0;
+            if (!tppl::parse_number(argv[++i], cow::TraceRing::kMaxCapacity, entries) || entries == 0) {
+                std::cerr << "Error: Invalid trace length '" << argv[i] << "'\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+            options.traceEntries = static_cast<size_t>(entries);
+        }
+        else if (arg == "--trace-file" && i + 1 < argc) options.traceFile = argv[++i];
+        else if (arg == "--decode-trace" && i + 2 < argc) return decodeTrace(argv[i + 1], argv[i + 2]);
+        else if (arg == "-j" && i + 1 < argc) {
+            unsigned long long threads = 0;
+            if (!tppl::parse_number(argv[++i], UINT_MAX, threads)) {
+                std::cerr << "Error: Invalid thread count '" << argv[i] << "'\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+            options.threads = static_cast<unsigned>(threads);
+        }
+        else if ((options.batch || options.inputs) && !(options.inputs && options.filePath.empty())) {
+            options.batchFiles.push_back(arg);
+        }
+        else options.filePath = arg;
+    }
+
+    if (cell == "int8") return run<int8_t>(options, argv[0]);
+    if (cell == "uint8") return run<uint8_t>(options, argv[0]);
+    if (cell == "int32") return run<int32_t>(options, argv[0]);
+    if (cell == "int64") return run<int64_t>(options, argv[0]);
+
+    std::cerr << "Error: Unknown cell type '" << cell << "'\n";
+    printUsage(argv[0]);
+    return 1;
+}
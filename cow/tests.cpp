@@ -1,8 +1,23 @@
 #include <gtest/gtest.h>
 #include <sstream>
+#include <fstream>
+#include <iterator>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <unistd.h>
+#include <dirent.h>
+#include <vector>
+#include <limits>
+#include <type_traits>
 #include "CowInterpreter.h"
+#include "OrderedRun.h"
+#include "CowScheduler.h"
+#include "CowCodegen.h"
+#include "CowCache.h"
 
-class CowTest : public ::testing::Test {
+// Каждый тест прогоняется во всех режимах исполнения
+class CowTest : public ::testing::TestWithParam<CowMode> {
 protected:
     std::stringstream ss_in;
     std::stringstream ss_out;
@@ -10,6 +25,7 @@ protected:
 
     void SetUp() override {
         cow = new CowInterpreter(ss_in, ss_out);
+        cow->setMode(GetParam());
     }
 
     void TearDown() override {
@@ -18,14 +34,14 @@ protected:
 };
 
 // 1. Тест базовой арифметики (MoO = +1, MOo = -1)
-TEST_F(CowTest, BasicArithmetic) {
+TEST_P(CowTest, BasicArithmetic) {
     // +1, +1, -1 = 1
     cow->run("MoO MoO MOo");
     EXPECT_EQ(cow->getValueAt(0), 1);
 }
 
 // 2. Тест перемещения указателя (moO ->, mOo <-)
-TEST_F(CowTest, PointerMovement) {
+TEST_P(CowTest, PointerMovement) {
     // inc, right, inc, inc, left
     cow->run("MoO moO MoO MoO mOo");
     
@@ -35,13 +51,13 @@ TEST_F(CowTest, PointerMovement) {
 }
 
 // 3. Тест очистки ячейки (OOO)
-TEST_F(CowTest, ZeroInstruction) {
+TEST_P(CowTest, ZeroInstruction) {
     cow->run("MoO MoO OOO");
     EXPECT_EQ(cow->getValueAt(0), 0);
 }
 
 // 4. Тест работы с регистром (MMM)
-TEST_F(CowTest, RegisterLogic) {
+TEST_P(CowTest, RegisterLogic) {
     // Установим 5
     std::string make5 = "MoO MoO MoO MoO MoO";
     
@@ -55,7 +71,7 @@ TEST_F(CowTest, RegisterLogic) {
 }
 
 // 5. Тест ввода/вывода чисел (oom, OOM)
-TEST_F(CowTest, InputOutputInt) {
+TEST_P(CowTest, InputOutputInt) {
     // oom читает ЦЕЛОЕ ЧИСЛО, а не char.
     // Поэтому подаем "65", а не "A".
     ss_in << "65"; 
@@ -67,15 +83,74 @@ TEST_F(CowTest, InputOutputInt) {
     EXPECT_EQ(ss_out.str(), "65");
 }
 
+// Разбор чисел в oom повторяет поведение in >> int
+TEST_P(CowTest, InputIntParsing) {
+    ss_in << "  -42\n+7 2147483647 -2147483648";
+    cow->run("oom OOM moO oom OOM moO oom OOM moO oom OOM");
+    EXPECT_EQ(ss_out.str(), "-4272147483647-2147483648");
+}
+
+TEST_P(CowTest, InputIntFailureIsSticky) {
+    // переполнение - ячейка не меняется, дальше ввод не читается
+    ss_in << "99999999999 5 X";
+    cow->run("MoO oom moO oom moO Moo");
+    EXPECT_EQ(cow->getValueAt(0), 1);
+    EXPECT_EQ(cow->getValueAt(1), 0);
+    EXPECT_EQ(cow->getValueAt(2), 0);
+}
+
+// Буферизованный вывод сбрасывается перед чтением и при ошибке
+struct RecordingInput : std::streambuf {
+    std::stringstream& out;
+    std::string seen;
+    char data = '7';
+    bool given = false;
+
+    explicit RecordingInput(std::stringstream& out) : out(out) {}
+
+    int underflow() override {
+        seen = out.str();
+        if (given) return traits_type::eof();
+        given = true;
+        setg(&data, &data, &data + 1);
+        return traits_type::to_int_type(data);
+    }
+};
+
+TEST_P(CowTest, OutputFlushedBeforeInput) {
+    std::stringstream out;
+    RecordingInput buf(out);
+    std::istream in(&buf);
+    CowInterpreter interp(in, out);
+    interp.setMode(GetParam());
+    interp.run("MoO OOM oom OOM");
+    EXPECT_EQ(buf.seen, "1");
+    EXPECT_EQ(out.str(), "17");
+}
+
+TEST_P(CowTest, OutputFlushedOnError) {
+    EXPECT_THROW(cow->run("MoO MoO OOM Moo mOo"), std::runtime_error);
+    EXPECT_EQ(ss_out.str(), std::string("2\x02"));
+}
+
+TEST_P(CowTest, LargeOutput) {
+    // вывод больше буфера
+    std::string source;
+    for (int i = 0; i < 65; i++) source += "MoO ";
+    for (int i = 0; i < 100000; i++) source += "Moo ";
+    cow->run(source);
+    EXPECT_EQ(ss_out.str(), std::string(100000, 'A'));
+}
+
 // 6. Тест условного оператора Moo (Char I/O)
-TEST_F(CowTest, ConditionalMoo_Input) {
+TEST_P(CowTest, ConditionalMoo_Input) {
     // Если значение 0 -> Moo читает char
     ss_in << "X";
     cow->run("Moo"); 
     EXPECT_EQ(cow->getValueAt(0), 88);
 }
 
-TEST_F(CowTest, ConditionalMoo_Output) {
+TEST_P(CowTest, ConditionalMoo_Output) {
     // Если значение !0 -> Moo выводит char
     // Используем oom, чтобы записать число 89 ('Y')
     ss_in << "89"; 
@@ -87,19 +162,28 @@ TEST_F(CowTest, ConditionalMoo_Output) {
 }
 
 // 7. Тест циклов (MOO ... moo)
-TEST_F(CowTest, LoopExecution) {
+TEST_P(CowTest, LoopExecution) {
     cow->run("MoO MoO MoO MOO MOo moo");
     EXPECT_EQ(cow->getValueAt(0), 0);
 }
 
 // 8. Тест пропуска цикла
-TEST_F(CowTest, LoopSkip) {
+TEST_P(CowTest, LoopSkip) {
     cow->run("MOO MoO moo");
     EXPECT_EQ(cow->getValueAt(0), 0);
 }
 
+// Вложенные циклы: 3 * (2 * 2) = 12 в ячейке 2
+TEST_P(CowTest, NestedLoops) {
+    cow->run("MoO MoO MoO MOO moO MoO MoO MOO moO MoO MoO mOo MOo moo mOo MOo moo");
+    EXPECT_EQ(cow->getValueAt(0), 0);
+    EXPECT_EQ(cow->getValueAt(1), 0);
+    EXPECT_EQ(cow->getValueAt(2), 12);
+    EXPECT_EQ(cow->getPointer(), 0);
+}
+
 // 9. Тест косвенного выполнения (mOO)
-TEST_F(CowTest, IndirectExecution) {
+TEST_P(CowTest, IndirectExecution) {
     std::string set6 = "MoO MoO MoO MoO MoO MoO";
     cow->run(set6 + " mOO");
     
@@ -107,12 +191,14 @@ TEST_F(CowTest, IndirectExecution) {
 }
 
 // Тест "Hello, World!"
-TEST_F(CowTest, HelloWorld) {
-    std::string source = 
+static const std::string kHelloWorld =
         "MoO MoO MoO MoO MoO MoO MoO MoO MOO moO MoO MoO MoO MoO MoO moO MoO MoO MoO MoO moO MoO MoO MoO MoO moO MoO MoO MoO MoO MoO MoO MoO "
         "MoO MoO moO MoO MoO MoO MoO mOo mOo mOo mOo mOo MOo moo moO moO moO moO Moo moO MOO mOo MoO moO MOo moo mOo MOo MOo MOo Moo MoO MoO "
         "MoO MoO MoO MoO MoO Moo Moo MoO MoO MoO Moo MMM mOo mOo mOo MoO MoO MoO MoO Moo moO Moo MOO moO moO MOo mOo mOo MOo moo moO moO MoO "
         "MoO MoO MoO MoO MoO MoO MoO Moo MMM MMM Moo MoO MoO MoO Moo MMM MOo MOo MOo Moo MOo MOo MOo MOo MOo MOo MOo MOo Moo mOo MoO Moo";
+
+TEST_P(CowTest, HelloWorld) {
+    std::string source = kHelloWorld;
     
     cow->run(source);
     
@@ -120,8 +206,7 @@ TEST_F(CowTest, HelloWorld) {
 }
 
 // Тест "Фибоначи"
-TEST_F(CowTest, Fibonaci) {
-    std::string source = R"(
+static const std::string kFibonacci = R"(
 MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO 
 MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO 
                                             c1v44 : ASCII code of comma
@@ -145,35 +230,826 @@ moo
 mOo mOo MoO MoO Moo Moo Moo                 c1    : output three dots
 )";
 
+TEST_P(CowTest, Fibonaci) {
+    std::string source = kFibonacci;
+
     cow->run(source);
 
     std::string expected = "1, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144, 233, 377, 610, 987, ...";
     EXPECT_EQ(ss_out.str(), expected);
 }
 
+// ==========================================
+// Оптимизатор: результат совпадает с построчным исполнением
+// ==========================================
+
+struct CowRunResult {
+    std::string output;
+    std::vector<int> tape;
+    size_t pointer;
+    int reg;
+    bool error;
+};
+
+static CowRunResult runInMode(CowMode mode, const std::string& source, const std::string& input = "") {
+    std::stringstream in(input), out;
+    CowInterpreter interp(in, out);
+    interp.setMode(mode);
+    bool error = false;
+    try {
+        interp.run(source);
+    } catch (const std::runtime_error&) {
+        error = true;
+    }
+    std::vector<int> tape;
+    for (size_t i = 0; i < 16; i++) tape.push_back(interp.getValueAt(i));
+    return {out.str(), tape, interp.getPointer(), interp.getRegister(), error};
+}
+
+static void expectSameAsBasic(const std::string& source, const std::string& input = "") {
+    CowRunResult basic = runInMode(CowMode::Basic, source, input);
+    for (CowMode mode : {CowMode::Optimized, CowMode::Jit}) {
+        CowRunResult result = runInMode(mode, source, input);
+        EXPECT_EQ(result.output, basic.output);
+        EXPECT_EQ(result.tape, basic.tape);
+        EXPECT_EQ(result.pointer, basic.pointer);
+        EXPECT_EQ(result.reg, basic.reg);
+        EXPECT_EQ(result.error, basic.error);
+    }
+}
+
+TEST(CowOptimizerTest, RunFolding) {
+    expectSameAsBasic("MoO MoO MoO MOo moO moO moO mOo MoO MOo MOo OOM");
+    expectSameAsBasic("moO mOo mOo");
+}
+
+TEST(CowOptimizerTest, ClearLoop) {
+    expectSameAsBasic("MoO MoO MoO MoO MOO MOo moo moO MoO");
+    expectSameAsBasic("oom MOO MoO moo OOM", "-5");
+}
+
+TEST(CowOptimizerTest, MultiplyAndCopyLoops) {
+    // ячейка1 += 3 * ячейка0, ячейка2 += ячейка0
+    expectSameAsBasic("oom MOO MOo moO MoO MoO MoO moO MoO mOo mOo moo moO OOM", "7");
+    // копирование влево
+    expectSameAsBasic("moO oom MOO mOo MoO moO MOo moo mOo OOM", "12");
+    // счётчик с шагом +1
+    expectSameAsBasic("oom MOO MoO moO MoO MoO mOo moo moO OOM", "-4");
+}
+
+TEST(CowOptimizerTest, UnderflowInsideFoldedLoop) {
+    expectSameAsBasic("MoO MOO mOo MoO moO MOo moo");
+    expectSameAsBasic("MOO mOo MoO moO MOo moo");
+}
+
+// mOO при известном значении ячейки заменяется нужной инструкцией
+TEST(CowOptimizerTest, IndirectWithKnownValue) {
+    CowProgram program("MoO MoO MoO MoO MoO MoO mOO OOM", CowMode::Optimized);
+    for (const cow::Instr& ins : program.getCode()) {
+        EXPECT_NE(ins.op, static_cast<uint32_t>(cow::mOO));
+    }
+
+    expectSameAsBasic("MoO MoO MoO MoO MoO MoO mOO OOM");
+    expectSameAsBasic("MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO mOO OOM");
+    expectSameAsBasic("MoO MoO MoO MoO mOO MOo mOO mOO OOM", "x");
+    expectSameAsBasic("MoO MoO MoO MoO MoO MoO MoO MoO mOO moO OOM");
+    expectSameAsBasic("mOO");
+    expectSameAsBasic("MoO MoO MoO mOO");
+    expectSameAsBasic("MoO MoO MoO MoO MoO MoO MoO mOO");
+}
+
+// Значение неизвестно до исполнения: все коды через таблицу обработчиков
+TEST(CowOptimizerTest, IndirectFromInput) {
+    for (int code = -1; code <= 13; code++) {
+        expectSameAsBasic("moO MoO MoO mOo oom mOO OOM moO OOM", std::to_string(code) + " 42");
+    }
+}
+
+TEST(CowOptimizerTest, Programs) {
+    expectSameAsBasic(kHelloWorld);
+    expectSameAsBasic("MoO MoO MoO MOO moO MoO MoO MOO moO MoO MoO mOo MOo moo mOo MOo moo");
+    expectSameAsBasic("Moo MOO Moo OOO Moo moo", "ab");
+    expectSameAsBasic("MoO MoO MoO MoO MoO MoO mOO MMM moO MMM OOM");
+}
+
+// Слова, разорванные посторонними символами, и перекрывающиеся слова
+TEST_P(CowTest, ParserSkipsComments) {
+    cow->run("xMoOx M o O MMoO MOMoO mo?o oo MoOO\nMo");
+    EXPECT_EQ(cow->getValueAt(0), 4);
+}
+
+TEST_P(CowTest, ParserNonAsciiText) {
+    cow->run("\xd0\xbc\xd1\x83 MoO \xff\xfeMoO\x80");
+    EXPECT_EQ(cow->getValueAt(0), 2);
+}
+
 // ==========================================
 // Негативные тесты (Exceptions)
 // ==========================================
 
-TEST_F(CowTest, ErrorUnderflow) {
+// Лента: дальний проход без перевыделений и выход за ёмкость
+TEST_P(CowTest, FarTapeWalk) {
+    std::string source;
+    for (int i = 0; i < 50000; i++) source += "moO ";
+    source += "MoO";
+    cow->run(source);
+    EXPECT_EQ(cow->getPointer(), 50000u);
+    EXPECT_EQ(cow->getValueAt(50000), 1);
+    EXPECT_EQ(cow->getValueAt(49999), 0);
+}
+
+TEST_P(CowTest, ErrorOverflow) {
+    std::stringstream in, out;
+    CowInterpreter small(in, out, 4);
+    small.setMode(GetParam());
+    EXPECT_THROW(small.run("moO moO moO moO"), std::runtime_error);
+    EXPECT_NO_THROW(small.run("moO moO moO MoO"));
+    EXPECT_EQ(small.getValueAt(3), 1);
+    EXPECT_EQ(small.getValueAt(4), 0);
+    EXPECT_THROW(small.run("MoO MOO MOo moO moO moO moO MoO mOo mOo mOo mOo moo"), std::runtime_error);
+}
+
+TEST_P(CowTest, ErrorUnderflow) {
     EXPECT_THROW(cow->run("mOo"), std::runtime_error);
 }
 
 // moo - это конец цикла (End Loop). Если встретили без начала - ошибка.
-TEST_F(CowTest, ErrorUnmatchedEnd) {
+TEST_P(CowTest, ErrorUnmatchedEnd) {
     EXPECT_THROW(cow->run("moo"), std::runtime_error);
 }
 
 // MOO - это начало цикла (Start Loop). Если не закрыли - ошибка.
-TEST_F(CowTest, ErrorUnmatchedStart) {
+TEST_P(CowTest, ErrorUnmatchedStart) {
     EXPECT_THROW(cow->run("MOO"), std::runtime_error);
 }
 
-TEST_F(CowTest, ErrorLoopInIndirect) {
+TEST_P(CowTest, ErrorLoopInIndirect) {
     // 0 - это код moo (End Loop). Нельзя выполнять переходы через mOO
     EXPECT_THROW(cow->run("mOO"), std::runtime_error);
 }
 
+INSTANTIATE_TEST_SUITE_P(AllModes, CowTest,
+    ::testing::Values(CowMode::Basic, CowMode::Optimized, CowMode::Jit));
+
+// JIT: ошибки из обратных вызовов и рост ленты
+TEST(CowJitTest, ErrorsFromHelpers) {
+    std::stringstream in, out;
+    CowInterpreter interp(in, out);
+    interp.setMode(CowMode::Jit);
+    EXPECT_THROW(interp.run("MoO MoO MoO mOO"), std::runtime_error);
+    EXPECT_THROW(interp.run("MoO OOM mOo"), std::runtime_error);
+    EXPECT_EQ(out.str(), "1");
+}
+
+TEST(CowJitTest, LongTape) {
+    std::string source = "MoO MoO MoO MoO MOO MOo";
+    for (int i = 0; i < 300; i++) source += " moO MoO";
+    for (int i = 0; i < 300; i++) source += " mOo";
+    source += " moo";
+    expectSameAsBasic(source);
+
+    std::stringstream in, out;
+    CowInterpreter interp(in, out);
+    interp.setMode(CowMode::Jit);
+    interp.run(source);
+    EXPECT_EQ(interp.getValueAt(300), 4);
+}
+
+// После выхода за ленту указатель тот же, что у байткода
+TEST(CowJitTest, PointerAfterOverflow) {
+    for (const char* source : {"moO moO moO moO", "moO moO MoO MOO moO moO moo", "moO moO mOo mOo mOo"}) {
+        std::stringstream in, out;
+        CowInterpreter optimized(in, out, 4), jit(in, out, 4);
+        optimized.setMode(CowMode::Optimized);
+        jit.setMode(CowMode::Jit);
+        EXPECT_THROW(optimized.run(source), std::runtime_error);
+        EXPECT_THROW(jit.run(source), std::runtime_error);
+        EXPECT_EQ(jit.getPointer(), optimized.getPointer()) << source;
+    }
+}
+
+// Одна скомпилированная программа на нескольких потоках
+TEST(CowProgramTest, SharedAcrossThreads) {
+    for (CowMode mode : {CowMode::Optimized, CowMode::Jit}) {
+        auto program = std::make_shared<const CowProgram>("oom MOO MOo moO MoO MoO mOo moo moO OOM", mode);
+        std::vector<std::string> outputs;
+        tppl::run_ordered<std::string>(64, 4,
+            [&](size_t i) {
+                std::stringstream in(std::to_string(i)), out;
+                CowExecution execution(in, out);
+                execution.run(*program);
+                return out.str();
+            },
+            [&](size_t, std::string& out) { outputs.push_back(out); });
+
+        ASSERT_EQ(outputs.size(), 64u);
+        for (size_t i = 0; i < outputs.size(); i++) EXPECT_EQ(outputs[i], std::to_string(2 * i));
+    }
+}
+
+TEST(CowProgramTest, ExecutionReusesProgram) {
+    CowProgram program("MoO MoO OOM");
+    std::stringstream in, out;
+    CowExecution execution(in, out);
+    execution.run(program);
+    execution.run(program);
+    EXPECT_EQ(out.str(), "22");
+    EXPECT_EQ(execution.getValueAt(0), 2);
+}
+
+// Пошаговое исполнение с бюджетом
+TEST(CowStepTest, ResumeMatchesRun) {
+    const char* source = "MoO MoO MoO MOO moO MoO MoO MOO moO MoO MoO mOo MOo moo mOo MOo moo moO moO OOM";
+    for (CowMode mode : {CowMode::Basic, CowMode::Optimized}) {
+        CowProgram program(source, mode);
+        std::stringstream in, out;
+        CowExecution execution(in, out);
+        execution.start(program);
+        size_t slices = 0;
+        while (execution.resume(3) == CowStatus::Suspended) slices++;
+        EXPECT_GT(slices, 1u);
+        EXPECT_EQ(out.str(), "12");
+        EXPECT_EQ(execution.getValueAt(2), 12);
+        EXPECT_EQ(execution.resume(3), CowStatus::Finished);
+    }
+}
+
+TEST(CowStepTest, InfiniteLoopSuspends) {
+    CowProgram program("MoO MOO moo");
+    std::stringstream in, out;
+    CowExecution execution(in, out);
+    execution.start(program);
+    EXPECT_EQ(execution.resume(1000), CowStatus::Suspended);
+    EXPECT_EQ(execution.resume(1000), CowStatus::Suspended);
+    EXPECT_EQ(execution.getSteps(), 2000u);
+}
+
+// Срез выполняет ровно столько инструкций, сколько разрешено
+TEST(CowStepTest, ExactBudget) {
+    CowProgram forever("MoO MOO moo", CowMode::Basic);
+    std::stringstream in, out;
+    CowExecution execution(in, out);
+    execution.start(forever);
+    EXPECT_EQ(execution.resume(0), CowStatus::Suspended);
+    EXPECT_EQ(execution.getSteps(), 0u);
+    EXPECT_EQ(execution.getValueAt(0), 0);
+    EXPECT_EQ(execution.resume(1), CowStatus::Suspended);
+    EXPECT_EQ(execution.getSteps(), 1u);
+    EXPECT_EQ(execution.getValueAt(0), 1);
+
+    CowProgram program("MoO MoO OOM", CowMode::Basic);
+    execution.start(program);
+    EXPECT_EQ(execution.resume(3), CowStatus::Suspended);
+    EXPECT_EQ(execution.getSteps(), 3u);
+    EXPECT_EQ(out.str(), "2");
+    EXPECT_EQ(execution.resume(1), CowStatus::Finished);
+    EXPECT_EQ(execution.getSteps(), 4u);
+}
+
+TEST(CowSchedulerTest, ManyTasksWithLimits) {
+    CowScheduler::Options options;
+    options.workers = 2;
+    options.sliceSteps = 100;
+    options.tapeCells = 1024;
+    CowScheduler scheduler(options);
+
+    auto doubler = std::make_shared<const CowProgram>("oom MOO MOo moO MoO MoO mOo moo moO OOM");
+    auto forever = std::make_shared<const CowProgram>("MoO MOO moo");
+    auto broken = std::make_shared<const CowProgram>("mOo");
+
+    std::vector<size_t> ids;
+    size_t loop = scheduler.submit(forever, "", 5000);
+    for (int i = 0; i < 200; i++) ids.push_back(scheduler.submit(doubler, std::to_string(i)));
+    size_t error = scheduler.submit(broken);
+    scheduler.wait();
+
+    for (int i = 0; i < 200; i++) {
+        CowTaskResult r = scheduler.result(ids[i]);
+        EXPECT_EQ(r.state, CowTaskState::Finished);
+        EXPECT_EQ(r.output, std::to_string(2 * i));
+    }
+    CowTaskResult limited = scheduler.result(loop);
+    EXPECT_EQ(limited.state, CowTaskState::StepLimit);
+    EXPECT_EQ(limited.steps, 5000u);
+    CowTaskResult failed = scheduler.result(error);
+    EXPECT_EQ(failed.state, CowTaskState::Failed);
+    EXPECT_EQ(failed.error, "Memory Underflow");
+    EXPECT_EQ(scheduler.active(), 0u);
+}
+
+// Завершённые задачи не держат исполнение; результат остаётся доступен
+TEST(CowSchedulerTest, ReleasesFinishedTasks) {
+    CowScheduler::Options options;
+    options.workers = 1;
+    options.sliceSteps = 10;
+    options.tapeCells = 1024;
+    CowScheduler scheduler(options);
+    auto program = std::make_shared<const CowProgram>("MoO MoO OOM");
+    for (int i = 0; i < 1000; i++) scheduler.submit(program);
+    scheduler.wait();
+    EXPECT_EQ(scheduler.active(), 0u);
+    EXPECT_EQ(program.use_count(), 1);
+    EXPECT_EQ(scheduler.result(999).output, "2");
+
+    options.sliceSteps = 0;
+    EXPECT_THROW(CowScheduler{options}, std::invalid_argument);
+    options.sliceSteps = 10;
+    options.workers = 0;
+    EXPECT_THROW(CowScheduler{options}, std::invalid_argument);
+}
+
+// Профилирование: счётчики по инструкциям и циклам
+TEST(CowProfileTest, CountsAndLoops) {
+    // offsets:       0   4   8   12  16  20  24  28
+    CowProgram program("MoO MoO MoO MOO MOo OOM moo OOM", CowMode::Basic);
+    std::stringstream in, out;
+    CowExecution execution(in, out);
+    CowProfile profile;
+    execution.runProfiled(program, profile);
+    EXPECT_EQ(out.str(), "2100");
+
+    ASSERT_EQ(profile.counts.size(), program.getCode().size());
+    EXPECT_EQ(profile.counts[0], 1u);
+    EXPECT_EQ(profile.counts[3], 1u);   // MOO
+    EXPECT_EQ(profile.counts[4], 3u);   // тело цикла
+    EXPECT_EQ(profile.iterations(program, 3), 3u);
+    EXPECT_EQ(profile.total(), 3u + 1u + 3u * 3u + 1u + 1u);
+    EXPECT_EQ(program.getSourceOffset(3), 12u);
+    EXPECT_EQ(program.getSourceOffset(7), 28u);
+
+    std::ostringstream report;
+    profile.report(report, program);
+    EXPECT_NE(report.str().find("@12: 1, 3, "), std::string::npos);
+    EXPECT_NE(report.str().find("@16 MOo 3"), std::string::npos);
+}
+
+TEST(CowProfileTest, OptimizedOffsetsAndErrors) {
+    CowProgram program("MoO MoO  moO moO mOo  MOO MOo moo  mOo mOo mOo", CowMode::Optimized);
+    EXPECT_EQ(program.getSourceOffset(0), 0u);   // ADD
+    EXPECT_EQ(program.getSourceOffset(1), 9u);   // MOVE
+    EXPECT_EQ(program.getSourceOffset(2), 22u);  // обнуление
+    EXPECT_EQ(program.getSourceOffset(3), 35u);
+
+    std::stringstream in, out;
+    CowExecution execution(in, out);
+    CowProfile profile;
+    EXPECT_THROW(execution.runProfiled(program, profile), std::runtime_error);
+    EXPECT_EQ(profile.counts[3], 1u);
+    EXPECT_EQ(profile.total(), 4u);
+
+    // После профилирующего запуска исполнение работает как обычно
+    CowProgram plain("MoO OOM");
+    execution.run(plain);
+    EXPECT_EQ(out.str(), "1");
+}
+
+// Ширина ячейки: каждый тип прогоняется во всех режимах
+template <typename Cell>
+std::string runCells(const std::string& source, const std::string& input, CowMode mode) {
+    std::stringstream in(input), out;
+    BasicCowInterpreter<Cell> interpreter(in, out, 1 << 16);
+    interpreter.setMode(mode);
+    interpreter.run(source);
+    return out.str();
+}
+
+template <typename Cell>
+class CowCellTest : public ::testing::Test {
+protected:
+    // Вывод одинаков во всех режимах исполнения
+    std::string run(const std::string& source, const std::string& input = "") {
+        std::string basic = runCells<Cell>(source, input, CowMode::Basic);
+        EXPECT_EQ(runCells<Cell>(source, input, CowMode::Optimized), basic) << source;
+        EXPECT_EQ(runCells<Cell>(source, input, CowMode::Jit), basic) << source;
+        return basic;
+    }
+};
+
+using CellTypes = ::testing::Types<int8_t, uint8_t, int32_t, int64_t>;
+TYPED_TEST_SUITE(CowCellTest, CellTypes);
+
+TYPED_TEST(CowCellTest, WrapsAtCellWidth) {
+    using Limits = std::numeric_limits<TypeParam>;
+    // max + 1 == min, 0 - 1 == max для беззнаковых и -1 для знаковых
+    std::string max = std::to_string(static_cast<long long>(Limits::max()));
+    EXPECT_EQ(this->run("oom MoO OOM", max), std::to_string(static_cast<long long>(Limits::min())));
+    EXPECT_EQ(this->run("MOo OOM"), std::is_signed<TypeParam>::value ? "-1" : max);
+    EXPECT_EQ(this->run("oom MoO MoO MoO MoO MoO MoO MoO MoO MoO MoO OOM", max),
+              std::to_string(static_cast<long long>(static_cast<TypeParam>(Limits::min() + 9))));
+}
+
+TYPED_TEST(CowCellTest, FoldedLoopsWrap) {
+    // 100 * 3 в ячейке 1 и копия через регистр
+    std::string source = "oom MOO MOo moO MoO MoO MoO mOo moo moO OOM MMM mOo MMM OOM";
+    std::string expected = std::to_string(static_cast<long long>(static_cast<TypeParam>(300)));
+    EXPECT_EQ(this->run(source, "100"), expected + expected);
+}
+
+TYPED_TEST(CowCellTest, InputRangeFollowsCellType) {
+    using Limits = std::numeric_limits<TypeParam>;
+    std::string tooBig = std::to_string(static_cast<unsigned long long>(Limits::max()) + 1);
+    // Число вне диапазона типа - неудачное чтение, ячейка не меняется
+    EXPECT_EQ(this->run("MoO oom OOM", tooBig), "1");
+    EXPECT_EQ(this->run("oom OOM", "-5"), std::is_signed<TypeParam>::value ? "-5" : "0");
+}
+
+TYPED_TEST(CowCellTest, CharIo) {
+    // Байт 200 читается как беззнаковый и приводится к ширине ячейки
+    std::string expected = std::to_string(static_cast<long long>(static_cast<TypeParam>(200)));
+    EXPECT_EQ(this->run("Moo OOM", "\xC8"), expected);
+    EXPECT_EQ(this->run("Moo Moo", "\xC8"), "\xC8");
+}
+
+TEST(CowTapeTest, ByteTapeIsDense) {
+    BasicCowTape<int8_t> bytes(4096);
+    BasicCowTape<int64_t> words(4096);
+    EXPECT_EQ(reinterpret_cast<char*>(&bytes[4095]) - reinterpret_cast<char*>(bytes.data()), 4095);
+    EXPECT_EQ(reinterpret_cast<char*>(&words[1]) - reinterpret_cast<char*>(words.data()), 8);
+
+    std::stringstream in("5000000000"), out;
+    BasicCowInterpreter<int64_t> interpreter(in, out);
+    interpreter.run("oom MoO OOM");
+    EXPECT_EQ(out.str(), "5000000001");
+    EXPECT_EQ(interpreter.getValueAt(0), 5000000001LL);
+}
+
+// Ёмкость по умолчанию указана в README и в справке
+TEST(CowTapeTest, OverflowError) {
+    EXPECT_EQ(CowTape::kDefaultCells, 67108864u);
+    std::stringstream in, out;
+    CowInterpreter interpreter(in, out, 4);
+    try {
+        interpreter.run("MoO MOO moO MoO moo");
+        FAIL() << "expected Memory Overflow";
+    } catch (const std::runtime_error& e) {
+        EXPECT_STREQ(e.what(), "Memory Overflow");
+    }
+}
+
+// ==========================================
+// Трансляция в C: собранная программа ведёт себя как интерпретатор
+// ==========================================
+
+#if defined(COW_C_COMPILER) && (defined(__unix__) || defined(__APPLE__))
+#include <sys/wait.h>
+
+struct AotCase {
+    std::string source;
+    std::string input;
+    size_t tapeCells = CowTape::kDefaultCells;
+};
+
+static std::string readAll(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// То, что напечатал бы cow, и состояние в формате COW_DUMP_STATE
+static void interpretLikeCli(const AotCase& c, CowMode mode, std::string& out, std::string& err) {
+    std::stringstream in(c.input), ss;
+    CowInterpreter interp(in, ss, c.tapeCells);
+    interp.setMode(mode);
+    err.clear();
+    try {
+        interp.run(c.source);
+        ss << "\n";
+    } catch (const std::runtime_error& e) {
+        err = std::string("\nruntime error: ") + e.what() + "\n";
+    }
+    out = ss.str();
+    err += "state " + std::to_string(interp.getPointer()) + " " + std::to_string(interp.getRegister()) + " "
+         + (interp.isRegisterLoaded() ? "1" : "0");
+    for (size_t i = 0; i < 16; i++) err += " " + std::to_string(interp.getValueAt(i));
+    err += "\n";
+}
+
+TEST(CowAotTest, CompiledProgramsMatchInterpreter) {
+    std::string tooLong;
+    for (int i = 0; i < 50000; i++) tooLong += "moO ";
+    tooLong += "MoO";
+    std::string manyChars;
+    for (int i = 0; i < 65; i++) manyChars += "MoO ";
+    for (int i = 0; i < 100000; i++) manyChars += "Moo ";
+
+    // Программы из тестов выше
+    std::vector<AotCase> cases = {
+        {"MoO MoO MOo", ""},
+        {"MoO moO MoO MoO mOo", ""},
+        {"MoO MoO OOO", ""},
+        {"MoO MoO MoO MoO MoO MMM OOO MMM", ""},
+        {"oom OOM", "65"},
+        {"oom OOM moO oom OOM moO oom OOM moO oom OOM", "  -42\n+7 2147483647 -2147483648"},
+        {"MoO oom moO oom moO Moo", "99999999999 5 X"},
+        {"MoO OOM oom OOM", "7"},
+        {"MoO MoO OOM Moo mOo", ""},
+        {manyChars, ""},
+        {"Moo", "X"},
+        {"oom Moo", "89"},
+        {"MoO MoO MoO MOO MOo moo", ""},
+        {"MOO MoO moo", ""},
+        {"MoO MoO MoO MOO moO MoO MoO MOO moO MoO MoO mOo MOo moo mOo MOo moo", ""},
+        {"MoO MoO MoO MoO MoO MoO mOO", ""},
+        {kHelloWorld, ""},
+        {kFibonacci, ""},
+        {"MoO MoO MoO MOo moO moO moO mOo MoO MOo MOo OOM", ""},
+        {"moO mOo mOo", ""},
+        {"MoO MoO MoO MoO MOO MOo moo moO MoO", ""},
+        {"oom MOO MoO moo OOM", "-5"},
+        {"oom MOO MOo moO MoO MoO MoO moO MoO mOo mOo moo moO OOM", "7"},
+        {"moO oom MOO mOo MoO moO MOo moo mOo OOM", "12"},
+        {"oom MOO MoO moO MoO MoO mOo moo moO OOM", "-4"},
+        {"MoO MOO mOo MoO moO MOo moo", ""},
+        {"MOO mOo MoO moO MOo moo", ""},
+        {"Moo MOO Moo OOO Moo moo", "ab"},
+        {"MoO MoO MoO MoO MoO MoO mOO MMM moO MMM OOM", ""},
+        {"xMoOx M o O MMoO MOMoO mo?o oo MoOO\nMo", ""},
+        {"\xd0\xbc\xd1\x83 MoO \xff\xfeMoO\x80", ""},
+        {tooLong, ""},
+        {"moO moO moO moO", "", 4},
+        {"moO moO moO MoO", "", 4},
+        {"MoO MOO MOo moO moO moO moO MoO mOo mOo mOo mOo moo", "", 4},
+        {"mOo", ""},
+        {"mOO", ""},
+        {"MoO MoO MoO mOO", ""},
+        {"MoO OOM mOo", ""},
+        {"oom MOO MOo moO MoO MoO mOo moo moO OOM", "21"},
+    };
+
+    std::string dir = ::testing::TempDir() + "cow_aot_" + std::to_string(::getpid());
+    ASSERT_EQ(std::system(("mkdir -p '" + dir + "'").c_str()), 0);
+
+    for (CowMode mode : {CowMode::Basic, CowMode::Optimized}) {
+        for (size_t i = 0; i < cases.size(); i++) {
+            const AotCase& c = cases[i];
+            std::string base = dir + "/case" + std::to_string(i);
+            {
+                CowProgram program(c.source, mode);
+                cow::CodegenOptions options;
+                options.tapeCells = c.tapeCells;
+                std::ofstream out(base + ".c");
+                cow::emit_c(program, out, options);
+                std::ofstream in(base + ".in", std::ios::binary);
+                in << c.input;
+            }
+
+            std::string build = std::string("'") + COW_C_COMPILER + "' -O1 -DCOW_DUMP_STATE -o '" + base
+                              + "' '" + base + ".c'";
+            ASSERT_EQ(std::system(build.c_str()), 0) << build;
+            std::string run = "'" + base + "' < '" + base + ".in' > '" + base + ".out' 2> '" + base + ".err'";
+            int status = std::system(run.c_str());
+
+            std::string out, err;
+            interpretLikeCli(c, mode, out, err);
+            bool failed = err.compare(0, 1, "\n") == 0;
+            SCOPED_TRACE("case " + std::to_string(i) + ": " + c.source.substr(0, 60));
+            EXPECT_EQ(WIFEXITED(status) ? WEXITSTATUS(status) : -1, failed ? 1 : 0);
+            EXPECT_EQ(readAll(base + ".out"), out);
+            EXPECT_EQ(readAll(base + ".err"), err);
+        }
+    }
+    std::system(("rm -rf '" + dir + "'").c_str());
+}
+
+TEST(CowAotTest, CellTypes) {
+    CowProgram program("oom MoO OOM");
+    std::ostringstream out;
+    cow::CodegenOptions options;
+    options.cell = "uint8";
+    cow::emit_c(program, out, options);
+    EXPECT_NE(out.str().find("typedef uint8_t cell;"), std::string::npos);
+    options.cell = "int16";
+    EXPECT_THROW(cow::emit_c(program, out, options), std::runtime_error);
+}
+
+#endif
+
+// Кэш байткода: повторная загрузка без разбора исходника
+TEST(CowCacheTest, RoundTripAndInvalidation) {
+    std::string dir = ::testing::TempDir() + "cow_cache_" + std::to_string(::getpid());
+    std::string source = "oom MOO MOo moO MoO MoO mOo moo moO OOM";
+
+    cow::BytecodeCache cache(dir);
+    auto first = cache.load(source, CowMode::Optimized);
+    auto second = cache.load(source, CowMode::Optimized);
+    EXPECT_EQ(cache.getMisses(), 1u);
+    EXPECT_EQ(cache.getHits(), 1u);
+    ASSERT_EQ(second->getCode().size(), first->getCode().size());
+    for (size_t pc = 0; pc < first->getCode().size(); pc++) {
+        EXPECT_EQ(second->getCode()[pc].op, first->getCode()[pc].op);
+        EXPECT_EQ(second->getCode()[pc].arg, first->getCode()[pc].arg);
+        EXPECT_EQ(second->getCode()[pc].aux, first->getCode()[pc].aux);
+        EXPECT_EQ(second->getSourceOffset(pc), first->getSourceOffset(pc));
+    }
+
+    std::stringstream in("21"), out;
+    CowInterpreter interp(in, out);
+    interp.run(*second);
+    EXPECT_EQ(out.str(), "42");
+
+    // Другой режим и изменённый исходник - отдельные записи
+    cache.load(source, CowMode::Basic);
+    cache.load(source + " OOM", CowMode::Optimized);
+    EXPECT_EQ(cache.getMisses(), 3u);
+    std::system(("rm -rf '" + dir + "'").c_str());
+}
+
+// Пересчитывает контрольную сумму, чтобы до проверки дошёл сам байткод
+static std::string resign(std::string data) {
+    cow::CacheHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    header.checksum = cow::hash_source(std::string_view(data).substr(sizeof(header)));
+    std::memcpy(&data[0], &header, sizeof(header));
+    return data;
+}
+
+static void patchInstr(std::string& data, size_t pc, size_t field, int32_t value) {
+    std::memcpy(&data[sizeof(cow::CacheHeader) + pc * sizeof(cow::Instr) + field], &value, sizeof(value));
+}
+
+TEST(CowCacheTest, RejectsDamagedData) {
+    std::string source = "MoO MOO MOo moo OOM";
+    CowProgram program(source, CowMode::Basic);
+    uint64_t hash = cow::hash_source(source);
+    std::string data = cow::serialize(program, hash, source.size());
+    ASSERT_NE(cow::deserialize(data, CowMode::Basic, hash, source.size()), nullptr);
+
+    EXPECT_EQ(cow::deserialize(data, CowMode::Optimized, hash, source.size()), nullptr);
+    EXPECT_EQ(cow::deserialize(data, CowMode::Basic, hash + 1, source.size()), nullptr);
+    EXPECT_EQ(cow::deserialize(data.substr(0, data.size() - 1), CowMode::Basic, hash, source.size()), nullptr);
+
+    std::string version = data;
+    version[8]++;
+    EXPECT_EQ(cow::deserialize(version, CowMode::Basic, hash, source.size()), nullptr);
+
+    // Изменённые байты без новой контрольной суммы
+    std::string flipped = data;
+    flipped.back() ^= 1;
+    EXPECT_EQ(cow::deserialize(flipped, CowMode::Basic, hash, source.size()), nullptr);
+
+    // Переход за пределы байткода и переход не на парный moo
+    std::string jump = data;
+    patchInstr(jump, 1, offsetof(cow::Instr, arg), 1000);
+    EXPECT_EQ(cow::deserialize(jump, CowMode::Basic, hash, source.size()), nullptr);
+    EXPECT_EQ(cow::deserialize(resign(jump), CowMode::Basic, hash, source.size()), nullptr);
+    std::string unpaired = data;
+    patchInstr(unpaired, 1, offsetof(cow::Instr, arg), 3);
+    EXPECT_EQ(cow::deserialize(resign(unpaired), CowMode::Basic, hash, source.size()), nullptr);
+}
+
+// Суперинструкции, которым JIT доверяет без проверок
+TEST(CowCacheTest, RejectsUnsafeSuperinstructions) {
+    std::string source = "moO MoO MOO moO moO MoO MoO mOo mOo mOo MoO moO MOo moo moO moO mOo OOM";
+    CowProgram program(source, CowMode::Optimized);
+    uint64_t hash = cow::hash_source(source);
+    std::string data = cow::serialize(program, hash, source.size());
+    ASSERT_NE(cow::deserialize(data, CowMode::Optimized, hash, source.size()), nullptr);
+
+    const std::vector<cow::Instr>& code = program.getCode();
+    size_t move = 0, loop = 0, mul = 0;
+    for (size_t pc = code.size(); pc-- > 0; ) {
+        if (code[pc].op == cow::MOVE) move = pc;
+        if (code[pc].op == cow::LOOP_MUL) loop = pc;
+        if (code[pc].op == cow::MUL_ADD && code[pc].arg < 0) mul = pc;
+    }
+    ASSERT_EQ(code[0].op, cow::MOVE);
+    ASSERT_GT(loop, 0u);
+    ASSERT_GT(mul, loop);
+
+    auto rejected = [&](size_t pc, size_t field, int32_t value) {
+        std::string damaged = data;
+        patchInstr(damaged, pc, field, value);
+        return cow::deserialize(resign(damaged), CowMode::Optimized, hash, source.size()) == nullptr;
+    };
+    EXPECT_TRUE(rejected(move, offsetof(cow::Instr, arg), -(1 << 28)));          // сдвиг ниже aux
+    EXPECT_TRUE(rejected(move, offsetof(cow::Instr, aux), INT32_MIN));
+    EXPECT_TRUE(rejected(loop, offsetof(cow::Instr, aux), 0));                   // не покрывает MUL_ADD
+    EXPECT_TRUE(rejected(loop, offsetof(cow::Instr, aux), 1));
+    EXPECT_TRUE(rejected(loop, offsetof(cow::Instr, arg), static_cast<int32_t>(mul)));
+    EXPECT_TRUE(rejected(mul, offsetof(cow::Instr, op), cow::MUL_ADD + 1));
+    EXPECT_TRUE(rejected(move + 1, offsetof(cow::Instr, op), cow::MUL_ADD));      // MUL_ADD вне цикла
+}
+
+// Испорченный сдвиг в файле кэша - промах, а не исполнение
+TEST(CowCacheTest, TamperedMoveIsMiss) {
+    std::string dir = ::testing::TempDir() + "cow_cache_move_" + std::to_string(::getpid());
+    std::string source = "moO moO moO MoO OOM";
+    {
+        cow::BytecodeCache cache(dir);
+        auto program = cache.load(source, CowMode::Jit);
+        ASSERT_EQ(program->getCode()[0].op, cow::MOVE);
+        ASSERT_EQ(cache.getMisses(), 1u);
+    }
+    std::string found;
+    if (DIR* listing = ::opendir(dir.c_str())) {
+        while (dirent* entry = ::readdir(listing)) {
+            std::string name = entry->d_name;
+            if (name.size() > 6 && name.compare(name.size() - 6, 6, ".cowbc") == 0) found = dir + "/" + name;
+        }
+        ::closedir(listing);
+    }
+    ASSERT_FALSE(found.empty());
+    std::string data;
+    {
+        std::ifstream in(found, std::ios::binary);
+        ASSERT_TRUE(in.is_open());
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    for (bool signedAgain : {false, true}) {
+        std::string damaged = data;
+        patchInstr(damaged, 0, offsetof(cow::Instr, arg), -(1 << 28));
+        if (signedAgain) damaged = resign(damaged);
+        {
+            std::ofstream out(found, std::ios::binary | std::ios::trunc);
+            out.write(damaged.data(), static_cast<std::streamsize>(damaged.size()));
+        }
+        cow::BytecodeCache cache(dir);
+        auto program = cache.load(source, CowMode::Jit);
+        EXPECT_EQ(cache.getMisses(), 1u);
+        EXPECT_EQ(cache.getHits(), 0u);
+
+        std::stringstream in, out;
+        CowInterpreter interp(in, out);
+        interp.run(*program);
+        EXPECT_EQ(out.str(), "1");
+    }
+    std::system(("rm -rf '" + dir + "'").c_str());
+}
+
+// Трасса: последние шаги перед ошибкой и дамп из обработчика сигнала
+TEST(CowTraceTest, RingKeepsLastEntries) {
+    cow::TraceRing ring(3);
+    EXPECT_EQ(ring.capacity(), 4u);
+    for (uint32_t i = 0; i < 10; i++) ring.record(i, cow::MoO, i, -static_cast<int64_t>(i));
+    std::vector<cow::TraceEntry> entries = ring.snapshot();
+    ASSERT_EQ(entries.size(), 4u);
+    EXPECT_EQ(entries.front().pc, 6u);
+    EXPECT_EQ(entries.back().pc, 9u);
+    EXPECT_EQ(entries.back().cell, -9);
+    EXPECT_EQ(ring.total(), 10u);
+    EXPECT_THROW(cow::TraceRing(cow::TraceRing::kMaxCapacity + 1), std::length_error);
+    EXPECT_THROW(cow::TraceRing(SIZE_MAX), std::length_error);
+}
+
+TEST(CowTraceTest, StepsBeforeError) {
+    std::string source = "MoO MoO\nMOO\n  mOo MOo\nmoo";
+    CowProgram program(source, CowMode::Basic);
+    std::stringstream in, out;
+    CowExecution execution(in, out);
+    cow::TraceRing ring(16);
+    execution.setTrace(&ring);
+    EXPECT_THROW(execution.run(program), std::runtime_error);
+
+    std::vector<cow::TraceEntry> entries = ring.snapshot();
+    ASSERT_EQ(entries.size(), 4u);
+    EXPECT_EQ(entries.back().op, cow::mOo);
+    EXPECT_EQ(entries.back().ptr, 0u);
+    EXPECT_EQ(entries.back().cell, 2);
+
+    std::ostringstream decoded;
+    cow::decode_trace(decoded, {entries.back()}, 3, program, source);
+    EXPECT_EQ(decoded.str(), "#3 pc 3 mOo @14 (3:3) ptr 0 cell 2\n");
+
+    // Пошаговый режим пишет в то же кольцо
+    ring.clear();
+    CowProgram loop("MoO MOO moo", CowMode::Basic);
+    execution.start(loop);
+    EXPECT_EQ(execution.resume(100), CowStatus::Suspended);
+    EXPECT_EQ(ring.total(), 100u);
+}
+
+TEST(CowTraceTest, RawDumpRoundTrip) {
+    std::string source = "MoO MoO MoO OOM";
+    cow::TraceRing ring(2);
+    ring.describe(CowMode::Optimized, cow::hash_source(source));
+    CowProgram program(source, CowMode::Optimized);
+    std::stringstream in, out;
+    CowExecution execution(in, out);
+    execution.setTrace(&ring);
+    execution.run(program);
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_TRUE(ring.dump_raw(fds[1]));
+    close(fds[1]);
+    std::string data;
+    char buffer[256];
+    for (ssize_t n; (n = read(fds[0], buffer, sizeof(buffer))) > 0; ) data.append(buffer, static_cast<size_t>(n));
+    close(fds[0]);
+
+    cow::TraceHeader header;
+    std::vector<cow::TraceEntry> entries;
+    ASSERT_TRUE(cow::parse_trace(data, header, entries));
+    EXPECT_EQ(header.sourceHash, cow::hash_source(source));
+    EXPECT_EQ(header.mode, static_cast<uint32_t>(CowMode::Optimized));
+    EXPECT_EQ(header.head, 3u);     // ADD, OOM, HALT
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].op, cow::OOM);
+    EXPECT_EQ(entries[0].cell, 3);
+    EXPECT_EQ(entries[1].op, cow::HALT);
+    EXPECT_FALSE(cow::parse_trace(data.substr(1), header, entries));
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,204 @@
+#ifndef PASCAL_AST_HPP
+#define PASCAL_AST_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <stdexcept>
+
+namespace Pascal {
+
+    enum class TokenType {
+        INTEGER, PLUS, MINUS, MUL, DIV, LPAREN, RPAREN,
+        BEGIN, END, DOT, ASSIGN, SEMI, ID, END_OF_FILE
+    };
+
+    struct Token {
+        TokenType type;
+        std::string_view value;     // срез исходного текста
+        size_t pos;                 // смещение в исходном тексте
+        int number;                 // значение INTEGER
+    };
+
+    // Арифметика программ: сложение, вычитание и умножение по модулю 2^32,
+    // деление с усечением к нулю; INT_MIN / -1 даёт INT_MIN
+    inline int wrap_add(int a, int b) { return static_cast<int>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b)); }
+    inline int wrap_sub(int a, int b) { return static_cast<int>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b)); }
+    inline int wrap_mul(int a, int b) { return static_cast<int>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b)); }
+    inline int wrap_neg(int a) { return static_cast<int>(0u - static_cast<uint32_t>(a)); }
+
+    inline int checked_div(int a, int b) {
+        if (b == 0) throw std::runtime_error("Division by zero");
+        if (b == -1) return wrap_neg(a);
+        return a / b;
+    }
+
+    inline int apply_binop(TokenType op, int a, int b) {
+        switch (op) {
+            case TokenType::PLUS: return wrap_add(a, b);
+            case TokenType::MINUS: return wrap_sub(a, b);
+            case TokenType::MUL: return wrap_mul(a, b);
+            case TokenType::DIV: return checked_div(a, b);
+            default: throw std::runtime_error("Unknown operator");
+        }
+    }
+
+    // Блочный распределитель для узлов дерева. Узлы не разрушаются по
+    // одному: память всех узлов программы освобождается вместе с ареной,
+    // а reset() оставляет блоки для следующей программы.
+    class Arena {
+    public:
+        explicit Arena(size_t block_size = 64 * 1024) : block_size_(block_size) {}
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* allocate(size_t size, size_t align) {
+            if (current_ < blocks_.size()) {
+                size_t offset = (used_ + align - 1) & ~(align - 1);
+                if (offset + size <= blocks_[current_].size) {
+                    used_ = offset + size;
+                    return blocks_[current_].data.get() + offset;
+                }
+            }
+            next_block(size + align);
+            size_t offset = (used_ + align - 1) & ~(align - 1);
+            used_ = offset + size;
+            return blocks_[current_].data.get() + offset;
+        }
+
+        template <typename T, typename... Args>
+        T* make(Args&&... args) {
+            static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        T* make_array(size_t count) {
+            static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+            if (count == 0) return nullptr;
+            T* items = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+            for (size_t i = 0; i < count; i++) new (items + i) T();
+            return items;
+        }
+
+        std::string_view copy(std::string_view text) {
+            if (text.empty()) return {};
+            char* data = static_cast<char*>(allocate(text.size(), 1));
+            std::memcpy(data, text.data(), text.size());
+            return std::string_view(data, text.size());
+        }
+
+        void reset() {
+            current_ = 0;
+            used_ = 0;
+        }
+
+        // Память, занятая блоками
+        size_t capacity() const {
+            size_t total = 0;
+            for (const Block& block : blocks_) total += block.size;
+            return total;
+        }
+
+    private:
+        struct Block {
+            std::unique_ptr<char[]> data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks_;
+        size_t block_size_;
+        size_t current_ = 0;
+        size_t used_ = 0;
+
+        // Следующий подходящий блок после reset() или новый
+        void next_block(size_t min_size) {
+            size_t next = blocks_.empty() ? 0 : current_ + 1;
+            while (next < blocks_.size() && blocks_[next].size < min_size) next++;
+            if (next == blocks_.size()) {
+                size_t size = std::max(block_size_, min_size);
+                blocks_.push_back({std::unique_ptr<char[]>(new char[size]), size});
+            }
+            current_ = next;
+            used_ = 0;
+        }
+    };
+
+    enum class NodeKind : uint8_t {
+        BinOp, UnaryOp, Num, Var, Assign, Compound, NoOp
+    };
+
+    class AST {
+    public:
+        NodeKind kind;
+        explicit AST(NodeKind k) : kind(k) {}
+    };
+
+    class BinOp : public AST {
+    public:
+        AST* left;
+        TokenType op;
+        AST* right;
+        BinOp(AST* l, TokenType o, AST* r) : AST(NodeKind::BinOp), left(l), op(o), right(r) {}
+    };
+
+    class UnaryOp : public AST {
+    public:
+        TokenType op;
+        AST* expr;
+        UnaryOp(TokenType o, AST* e) : AST(NodeKind::UnaryOp), op(o), expr(e) {}
+    };
+
+    class Num : public AST {
+    public:
+        int value;
+        explicit Num(int v) : AST(NodeKind::Num), value(v) {}
+    };
+
+    class Var : public AST {
+    public:
+        std::string_view value;     // имя в исходном тексте
+        int32_t slot = -1;          // ячейка переменной, задаёт Resolver
+        explicit Var(std::string_view name) : AST(NodeKind::Var), value(name) {}
+    };
+
+    class Assign : public AST {
+    public:
+        Var* left;
+        AST* right;
+        Assign(Var* l, AST* r) : AST(NodeKind::Assign), left(l), right(r) {}
+    };
+
+    class Compound : public AST {
+    public:
+        AST** children = nullptr;
+        size_t count = 0;
+        Compound() : AST(NodeKind::Compound) {}
+
+        AST** begin() const { return children; }
+        AST** end() const { return children + count; }
+    };
+
+    class NoOp : public AST {
+    public:
+        NoOp() : AST(NodeKind::NoOp) {}
+    };
+
+    // Кадр явного стека обхода. Проходы по дереву не рекурсивны, чтобы
+    // глубина вложенности программы ограничивалась только памятью;
+    // state - сколько детей узла уже обработано.
+    struct Frame {
+        AST* node;
+        size_t state;
+    };
+}
+
+#endif
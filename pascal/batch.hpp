@@ -0,0 +1,92 @@
+#ifndef PASCAL_BATCH_HPP
+#define PASCAL_BATCH_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <istream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include "interpreter.hpp"
+#include "OrderedRun.h"
+
+namespace Pascal {
+
+    // Итог одной программы пакета: вывод как у одиночного запуска и текст
+    // ошибки, если она была
+    struct BatchResult {
+        std::string output;
+        std::string error;
+    };
+
+    inline void print_variables(std::ostream& out, const std::map<std::string, int>& variables) {
+        if (variables.empty()) {
+            out << "No variables defined.\n";
+            return;
+        }
+        out << "Variables:\n";
+        for (const auto& pair : variables) out << pair.first << " = " << pair.second << "\n";
+    }
+
+    inline BatchResult run_program(Interpreter& interp, std::string_view code) {
+        BatchResult result;
+        try {
+            std::ostringstream out;
+            print_variables(out, interp.interpret(code));
+            result.output = out.str();
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+        return result;
+    }
+
+    // Следующая программа потока в виде "<длина в байтах>\n<текст>".
+    // false - поток кончился до начала программы.
+    inline bool read_program(std::istream& in, std::string& program) {
+        in >> std::ws;
+        if (in.peek() == std::char_traits<char>::eof()) return false;
+        size_t length = 0;
+        if (!(in >> length) || in.get() != '\n') {
+            throw std::runtime_error("Malformed batch input: expected program length");
+        }
+        program.resize(length);
+        if (length > 0 && !in.read(&program[0], static_cast<std::streamsize>(length))) {
+            throw std::runtime_error("Malformed batch input: program is shorter than its length");
+        }
+        return true;
+    }
+
+    // Пул интерпретаторов, по одному на поток. Интерпретатор живёт между
+    // программами и вызовами run(), так что арена, таблица имён и буферы
+    // обхода выделяются один раз и дальше только переиспользуются.
+    class BatchRunner {
+    public:
+        explicit BatchRunner(unsigned threads, Mode mode = Mode::Bytecode, bool optimize = true) {
+            threads = std::max(1u, threads);
+            for (unsigned t = 0; t < threads; t++) {
+                interpreters_.push_back(std::make_unique<Interpreter>());
+                interpreters_.back()->setMode(mode);
+                interpreters_.back()->setOptimize(optimize);
+            }
+        }
+
+        unsigned threads() const { return static_cast<unsigned>(interpreters_.size()); }
+
+        // work(interp, i) исполняет i-ю программу и возвращает BatchResult;
+        // результаты приходят в emit(i, result) в порядке номеров
+        template <typename Work, typename Emit>
+        void run(size_t count, Work work, Emit emit) {
+            tppl::run_ordered<BatchResult>(count, threads(),
+                [&](unsigned worker, size_t i) { return work(*interpreters_[worker], i); },
+                emit);
+        }
+
+    private:
+        std::vector<std::unique_ptr<Interpreter>> interpreters_;
+    };
+}
+
+#endif
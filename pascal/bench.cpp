@@ -0,0 +1,262 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include "interpreter.hpp"
+#include "CommandLine.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Замеры интерпретатора на сгенерированных программах растущего размера.
+// Каждая пара (вид программы, размер) меряется в отдельном дочернем
+// процессе, чтобы пиковая память (ru_maxrss из wait4) относилась только
+// к ней. По строкам одного вида видно, как время растёт с размером.
+
+void printUsage(const char* progName) {
+    std::cout << "Pascal Benchmark\n";
+    std::cout << "----------------\n";
+    std::cout << "Usage:\n";
+    std::cout << "  " << progName << " [--csv] [--tree | --jit] [--time SECONDS] [--max-size N] [kind...]\n\n";
+    std::cout << "Description:\n";
+    std::cout << "  Generates programs of each kind in sizes 10^3, 10^4, ... up to --max-size and\n";
+    std::cout << "  reports lexing, parsing and evaluation time and peak memory. Parse time\n";
+    std::cout << "  excludes lexing. Evaluation covers resolving variables, optimizing and running\n";
+    std::cout << "  the program in the chosen mode.\n\n";
+    std::cout << "Kinds:\n";
+    std::cout << "  assignments         Many short assignments over a few variables.\n";
+    std::cout << "  expression          One assignment with a long expression.\n";
+    std::cout << "  nesting             Deeply nested parentheses and BEGIN/END blocks.\n";
+    std::cout << "  variables           Every assignment defines a new variable.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --csv               Machine-readable output.\n";
+    std::cout << "  --tree              Evaluate by walking the tree instead of the bytecode VM.\n";
+    std::cout << "  --jit               Evaluate by compiling the bytecode to x86-64 machine code.\n";
+    std::cout << "  --time SECONDS      Minimum measuring time per phase (default: 0.2).\n";
+    std::cout << "  --max-size N        Largest program size, 1000 to 1000000000 (default: 1000000).\n";
+}
+
+// Генераторы: size - число операторов, слагаемых или уровней вложенности
+static std::string assignments(size_t size) {
+    std::string code = "BEGIN\n";
+    for (int v = 0; v < 16; v++) code += "  v" + std::to_string(v) + " := " + std::to_string(v + 1) + ";\n";
+    for (size_t i = 0; i < size; i++) {
+        code += "  v" + std::to_string(i % 16) + " := v" + std::to_string((i * 7 + 3) % 16) + " * 3 + v"
+              + std::to_string((i * 5 + 1) % 16) + " / 7 - " + std::to_string(i % 100) + ";\n";
+    }
+    return code + "  done := 1\nEND.";
+}
+
+static std::string expression(size_t size) {
+    static const char* ops[] = {" + ", " - ", " * ", " / "};
+    std::string code = "BEGIN\n  a := 3;\n  x := 1";
+    for (size_t i = 0; i < size; i++) {
+        code += ops[i % 4];
+        code += i % 3 ? "a" : std::to_string(i % 97 + 1);
+    }
+    return code + "\nEND.";
+}
+
+static std::string nesting(size_t size) {
+    std::string code;
+    size_t blocks = size / 2;
+    for (size_t i = 0; i < blocks; i++) code += "BEGIN ";
+    code += "x := " + std::string(size - blocks, '(') + "1 + 2" + std::string(size - blocks, ')');
+    for (size_t i = 0; i < blocks; i++) code += " END";
+    return code + ".";
+}
+
+static std::string variables(size_t size) {
+    std::string code = "BEGIN\n  v0 := 1";
+    for (size_t i = 1; i < size; i++) {
+        code += ";\n  v" + std::to_string(i) + " := v" + std::to_string(i - 1) + " + " + std::to_string(i % 10);
+    }
+    return code + "\nEND.";
+}
+
+struct Kind {
+    const char* name;
+    std::string (*generate)(size_t);
+};
+
+struct Sample {
+    double lex = 0;
+    double parse = 0;
+    double eval = 0;
+    uint64_t tokens = 0;
+    uint64_t bytes = 0;
+    long peakKb = 0;
+    bool ok = false;
+};
+
+static double seconds(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+// Повторяет f, пока не наберётся minTime; время одного вызова
+static double measure(double minTime, const std::function<void()>& f) {
+    auto begin = std::chrono::steady_clock::now();
+    size_t calls = 0;
+    do {
+        f();
+        calls++;
+    } while (seconds(std::chrono::steady_clock::now() - begin) < minTime);
+    return seconds(std::chrono::steady_clock::now() - begin) / static_cast<double>(calls);
+}
+
+static void measurePhases(const std::string& code, Pascal::Mode mode, double minTime, Sample& sample) {
+    using namespace Pascal;
+    sample.bytes = code.size();
+
+    sample.lex = measure(minTime, [&] {
+        Lexer lexer(code);
+        uint64_t tokens = 1;
+        while (lexer.get_next_token().type != TokenType::END_OF_FILE) tokens++;
+        sample.tokens = tokens;
+    });
+
+    Arena arena;
+    AST* tree = nullptr;
+    double parse = measure(minTime, [&] {
+        arena.reset();
+        Lexer lexer(code);
+        Parser parser(lexer, arena);
+        tree = parser.parse();
+    });
+    sample.parse = std::max(0.0, parse - sample.lex);
+
+    // Дерево разбора не меняется: оптимизатор строит новые узлы в своей арене
+    Arena work;
+    SymbolTable symbols;
+    Interpreter interp;
+    interp.setMode(mode);
+    sample.eval = measure(minTime, [&] {
+        work.reset();
+        symbols.clear();
+        Resolver(symbols).resolve(tree);
+        interp.execute(Optimizer(work).optimize(tree, symbols.size()), symbols);
+    });
+}
+
+static Sample measureInChild(const std::string& code, Pascal::Mode mode, double minTime) {
+    int fds[2];
+    Sample sample;
+    if (pipe(fds) != 0) return sample;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        Sample result;
+        try {
+            measurePhases(code, mode, minTime, result);
+        } catch (const std::exception& e) {
+            std::cerr << "error: " << e.what() << "\n";
+            _exit(1);
+        }
+        ssize_t written = write(fds[1], &result, sizeof(result));
+        _exit(written == static_cast<ssize_t>(sizeof(result)) ? 0 : 1);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        return sample;
+    }
+
+    Sample result;
+    ssize_t got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid) return sample;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || got != static_cast<ssize_t>(sizeof(result))) return sample;
+
+    sample = result;
+    sample.peakKb = usage.ru_maxrss;
+#ifdef __APPLE__
+    sample.peakKb /= 1024;  // там байты
+#endif
+    sample.ok = true;
+    return sample;
+}
+
+int main(int argc, char* argv[]) {
+    bool csv = false;
+    double minTime = 0.2;
+    size_t maxSize = 1000000;
+    Pascal::Mode mode = Pascal::Mode::Bytecode;
+    std::vector<std::string> only;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--csv") csv = true;
+        else if (arg == "--tree") mode = Pascal::Mode::Tree;
+        else if (arg == "--jit") mode = Pascal::Mode::Jit;
+        else if (arg == "--time") {
+            if (i + 1 >= argc || !tppl::parse_seconds(argv[++i], minTime)) {
+                std::cerr << "Error: --time expects a positive number of seconds\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        else if (arg == "--max-size") {
+            // размеры растут в 10 раз, граница не даёт им переполниться
+            unsigned long long size = 0;
+            if (i + 1 >= argc || !tppl::parse_number(argv[++i], 1000000000, size) || size < 1000) {
+                std::cerr << "Error: --max-size expects a number from 1000 to 1000000000\n";
+                printUsage(argv[0]);
+                return 1;
+            }
+            maxSize = static_cast<size_t>(size);
+        }
+        else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        else only.push_back(arg);
+    }
+
+    const Kind kinds[] = {
+        {"assignments", assignments},
+        {"expression", expression},
+        {"nesting", nesting},
+        {"variables", variables},
+    };
+
+    if (csv) std::cout << "kind,size,bytes,tokens,lex_ms,parse_ms,eval_ms,mtokens_per_s,peak_kb\n";
+    else std::printf("%-12s %9s %11s %10s %10s %10s %10s %10s %10s\n",
+                     "kind", "size", "bytes", "tokens", "lex ms", "parse ms", "eval ms", "Mtok/s", "peak KB");
+
+    int failures = 0;
+    for (const Kind& kind : kinds) {
+        if (!only.empty() && std::find(only.begin(), only.end(), kind.name) == only.end()) continue;
+
+        for (size_t size = 1000; size <= maxSize; size *= 10) {
+            Sample s = measureInChild(kind.generate(size), mode, minTime);
+            if (!s.ok) {
+                std::cerr << "Error: " << kind.name << " of size " << size << " failed\n";
+                failures++;
+                continue;
+            }
+
+            double total = s.lex + s.parse + s.eval;
+            double rate = static_cast<double>(s.tokens) / total / 1e6;
+            if (csv) {
+                std::printf("%s,%zu,%llu,%llu,%.3f,%.3f,%.3f,%.1f,%ld\n", kind.name, size,
+                            static_cast<unsigned long long>(s.bytes), static_cast<unsigned long long>(s.tokens),
+                            s.lex * 1e3, s.parse * 1e3, s.eval * 1e3, rate, s.peakKb);
+            } else {
+                std::printf("%-12s %9zu %11llu %10llu %10.3f %10.3f %10.3f %10.1f %10ld\n", kind.name, size,
+                            static_cast<unsigned long long>(s.bytes), static_cast<unsigned long long>(s.tokens),
+                            s.lex * 1e3, s.parse * 1e3, s.eval * 1e3, rate, s.peakKb);
+            }
+            std::fflush(stdout);
+        }
+    }
+    return failures ? 1 : 0;
+}
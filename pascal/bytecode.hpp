@@ -0,0 +1,202 @@
+#ifndef PASCAL_BYTECODE_HPP
+#define PASCAL_BYTECODE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include "ast.hpp"
+#include "symbols.hpp"
+
+namespace Pascal {
+
+    // Команды стековой машины. Выражение вычисляется в обратной польской
+    // записи, присваивание снимает значение со стека в ячейку переменной.
+    enum class OpCode : uint8_t {
+        PUSH,   // arg - константа
+        LOAD,   // arg - ячейка
+        STORE,  // arg - ячейка
+        ADD, SUB, MUL, DIV, NEG,
+        HALT
+    };
+
+    struct Instr {
+        OpCode op;
+        int32_t arg;
+    };
+
+    struct Chunk {
+        std::vector<Instr> code;
+        std::vector<std::string> names;     // имя переменной по номеру ячейки
+        size_t max_stack = 0;
+    };
+
+    // Переводит разобранную программу с разрешёнными ячейками переменных
+    // (см. Resolver) в байткод
+    class Compiler {
+    public:
+        Chunk compile(AST* root, const SymbolTable& symbols) {
+            Chunk chunk;
+            compile(root, symbols, chunk);
+            return chunk;
+        }
+
+        // Перезаписывает chunk, сохраняя выделенную им память
+        void compile(AST* root, const SymbolTable& symbols, Chunk& chunk) {
+            chunk_ = &chunk;
+            chunk.code.clear();
+            chunk.max_stack = 0;
+            depth_ = 0;
+            chunk.names.resize(symbols.size());
+            for (size_t i = 0; i < symbols.size(); i++) {
+                chunk.names[i].assign(symbols.name(static_cast<int32_t>(i)));
+            }
+            statement(root);
+            chunk.code.push_back({OpCode::HALT, 0});
+        }
+
+    private:
+        Chunk* chunk_ = nullptr;
+        size_t depth_ = 0;
+        std::vector<Frame> frames_;
+
+        void emit(OpCode op, int32_t arg, int effect) {
+            chunk_->code.push_back({op, arg});
+            depth_ = static_cast<size_t>(static_cast<long>(depth_) + effect);
+            chunk_->max_stack = std::max(chunk_->max_stack, depth_);
+        }
+
+        // Обратная польская запись обходом в глубину с явным стеком
+        void statement(AST* root) {
+            std::vector<Frame>& frames = frames_;
+            frames.clear();
+            frames.push_back({root, 0});
+            while (!frames.empty()) {
+                Frame& frame = frames.back();
+                AST* node = frame.node;
+                size_t state = frame.state++;
+                switch (node->kind) {
+                    case NodeKind::Compound: {
+                        auto compound = static_cast<Compound*>(node);
+                        if (state < compound->count) frames.push_back({compound->children[state], 0});
+                        else frames.pop_back();
+                        break;
+                    }
+                    case NodeKind::Assign: {
+                        auto assign = static_cast<Assign*>(node);
+                        if (state == 0) {
+                            frames.push_back({assign->right, 0});
+                        } else {
+                            emit(OpCode::STORE, assign->left->slot, -1);
+                            frames.pop_back();
+                        }
+                        break;
+                    }
+                    case NodeKind::NoOp:
+                        frames.pop_back();
+                        break;
+                    case NodeKind::Num:
+                        emit(OpCode::PUSH, static_cast<Num*>(node)->value, 1);
+                        frames.pop_back();
+                        break;
+                    case NodeKind::Var:
+                        emit(OpCode::LOAD, static_cast<Var*>(node)->slot, 1);
+                        frames.pop_back();
+                        break;
+                    case NodeKind::UnaryOp: {
+                        auto unary = static_cast<UnaryOp*>(node);
+                        if (unary->op != TokenType::PLUS && unary->op != TokenType::MINUS) {
+                            throw std::runtime_error("Unknown unary operator");
+                        }
+                        if (state == 0) {
+                            frames.push_back({unary->expr, 0});
+                        } else {
+                            if (unary->op == TokenType::MINUS) emit(OpCode::NEG, 0, 0);
+                            frames.pop_back();
+                        }
+                        break;
+                    }
+                    case NodeKind::BinOp: {
+                        auto binop = static_cast<BinOp*>(node);
+                        OpCode op = binary(binop->op);
+                        if (state < 2) {
+                            frames.push_back({state == 0 ? binop->left : binop->right, 0});
+                        } else {
+                            emit(op, 0, -1);
+                            frames.pop_back();
+                        }
+                        break;
+                    }
+                    default:
+                        throw std::runtime_error("Unknown AST node");
+                }
+            }
+        }
+
+        static OpCode binary(TokenType op) {
+            switch (op) {
+                case TokenType::PLUS: return OpCode::ADD;
+                case TokenType::MINUS: return OpCode::SUB;
+                case TokenType::MUL: return OpCode::MUL;
+                case TokenType::DIV: return OpCode::DIV;
+                default: throw std::runtime_error("Unknown operator");
+            }
+        }
+    };
+
+    // Исполняет байткод. Ячейки и стек выделяются один раз на запуск,
+    // результат - значения присвоенных переменных.
+    class VM {
+    public:
+        std::map<std::string, int> run(const Chunk& chunk) {
+            slots_.assign(chunk.names.size(), 0);
+            defined_.assign(chunk.names.size(), 0);
+            stack_.resize(chunk.max_stack + 1);
+
+            const Instr* pc = chunk.code.data();
+            int* sp = stack_.data();     // первая свободная позиция
+            for (;;) {
+                const Instr& ins = *pc++;
+                switch (ins.op) {
+                    case OpCode::PUSH:
+                        *sp++ = ins.arg;
+                        break;
+                    case OpCode::LOAD:
+                        if (!defined_[ins.arg]) {
+                            throw std::runtime_error("Variable not found: " + chunk.names[ins.arg]);
+                        }
+                        *sp++ = slots_[ins.arg];
+                        break;
+                    case OpCode::STORE:
+                        slots_[ins.arg] = *--sp;
+                        defined_[ins.arg] = 1;
+                        break;
+                    case OpCode::ADD: sp--; sp[-1] = wrap_add(sp[-1], sp[0]); break;
+                    case OpCode::SUB: sp--; sp[-1] = wrap_sub(sp[-1], sp[0]); break;
+                    case OpCode::MUL: sp--; sp[-1] = wrap_mul(sp[-1], sp[0]); break;
+                    case OpCode::DIV: sp--; sp[-1] = checked_div(sp[-1], sp[0]); break;
+                    case OpCode::NEG: sp[-1] = wrap_neg(sp[-1]); break;
+                    case OpCode::HALT: return result(chunk);
+                }
+            }
+        }
+
+    private:
+        std::vector<int> slots_;
+        std::vector<char> defined_;
+        std::vector<int> stack_;
+
+        std::map<std::string, int> result(const Chunk& chunk) const {
+            std::map<std::string, int> variables;
+            for (size_t i = 0; i < chunk.names.size(); i++) {
+                if (defined_[i]) variables.emplace(chunk.names[i], slots_[i]);
+            }
+            return variables;
+        }
+    };
+}
+
+#endif
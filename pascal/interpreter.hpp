@@ -2,6 +2,7 @@
 #define PASCAL_INTERPRETER_HPP
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <memory>
@@ -9,154 +10,122 @@
 #include <cctype>
 #include <stdexcept>
 #include <algorithm>
+#include <cstdint>
+#include "ast.hpp"
+#include "symbols.hpp"
+#include "optimizer.hpp"
+#include "bytecode.hpp"
+#include "jit.hpp"
+#include "stats.hpp"
 
 namespace Pascal {
 
-    enum class TokenType {
-        INTEGER, PLUS, MINUS, MUL, DIV, LPAREN, RPAREN,
-        BEGIN, END, DOT, ASSIGN, SEMI, ID, END_OF_FILE
-    };
-
-    struct Token {
-        TokenType type;
-        std::string value;
-    };
-
+    // Токены - срезы исходного текста, поэтому текст должен жить, пока
+    // используются токены и построенное по ним дерево
     class Lexer {
     public:
-        explicit Lexer(const std::string& text) : text_(text), pos_(0) {
-            current_char_ = text_.empty() ? '\0' : text_[0];
-        }
+        explicit Lexer(std::string_view text) : text_(text), pos_(0) {}
 
         Token get_next_token() {
-            while (current_char_ != '\0') {
-                if (std::isspace(current_char_)) {
+            while (pos_ < text_.size()) {
+                char c = text_[pos_];
+                if (c == '\0') break;       // как и раньше, нулевой символ завершает текст
+                if (is_space(c)) {
                     skip_whitespace();
                     continue;
                 }
-                if (std::isdigit(current_char_)) {
-                    return {TokenType::INTEGER, number()};
-                }
-                if (std::isalpha(current_char_)) {
-                    return id();
-                }
-                
-                if (current_char_ == ':') {
+                if (is_digit(c)) return number();
+                if (is_alpha(c)) return id();
+
+                size_t start = pos_;
+                if (c == ':') {
                     advance();
                     skip_whitespace();
-                    if (current_char_ == '=') {
+                    if (pos_ < text_.size() && text_[pos_] == '=') {
                         advance();
-                        return {TokenType::ASSIGN, ":="};
+                        return make(TokenType::ASSIGN, start);
                     }
                     throw std::runtime_error("Syntax Error: expected '=' after ':'");
                 }
 
-                if (current_char_ == ';') { advance(); return {TokenType::SEMI, ";"}; }
-                if (current_char_ == '+') { advance(); return {TokenType::PLUS, "+"}; }
-                if (current_char_ == '-') { advance(); return {TokenType::MINUS, "-"}; }
-                if (current_char_ == '*') { advance(); return {TokenType::MUL, "*"}; }
-                if (current_char_ == '/') { advance(); return {TokenType::DIV, "/"}; }
-                if (current_char_ == '(') { advance(); return {TokenType::LPAREN, "("}; }
-                if (current_char_ == ')') { advance(); return {TokenType::RPAREN, ")"}; }
-                if (current_char_ == '.') { advance(); return {TokenType::DOT, "."}; }
-
-                throw std::runtime_error("Unknown character: " + std::string(1, current_char_));
+                TokenType type;
+                switch (c) {
+                    case ';': type = TokenType::SEMI; break;
+                    case '+': type = TokenType::PLUS; break;
+                    case '-': type = TokenType::MINUS; break;
+                    case '*': type = TokenType::MUL; break;
+                    case '/': type = TokenType::DIV; break;
+                    case '(': type = TokenType::LPAREN; break;
+                    case ')': type = TokenType::RPAREN; break;
+                    case '.': type = TokenType::DOT; break;
+                    default: throw std::runtime_error("Unknown character: " + std::string(1, c));
+                }
+                advance();
+                return make(type, start);
             }
-            return {TokenType::END_OF_FILE, ""};
+            return {TokenType::END_OF_FILE, std::string_view(), pos_, 0};
         }
 
     private:
-        std::string text_;
+        std::string_view text_;
         size_t pos_;
-        char current_char_;
 
-        void advance() {
-            pos_++;
-            if (pos_ >= text_.length()) {
-                current_char_ = '\0';
-            } else {
-                current_char_ = text_[pos_];
-            }
+        static bool is_space(char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }
+        static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+        static bool is_alpha(char c) { return std::isalpha(static_cast<unsigned char>(c)) != 0; }
+        static bool is_alnum(char c) { return std::isalnum(static_cast<unsigned char>(c)) != 0; }
+
+        void advance() { pos_++; }
+
+        Token make(TokenType type, size_t start, int number = 0) const {
+            return {type, text_.substr(start, pos_ - start), start, number};
         }
 
         void skip_whitespace() {
-            while (current_char_ != '\0' && std::isspace(current_char_)) {
-                advance();
-            }
+            while (pos_ < text_.size() && is_space(text_[pos_])) advance();
         }
 
-        std::string number() {
-            std::string result;
-            while (current_char_ != '\0' && std::isdigit(current_char_)) {
-                result += current_char_;
+        Token number() {
+            size_t start = pos_;
+            int64_t value = 0;
+            while (pos_ < text_.size() && is_digit(text_[pos_])) {
+                value = value * 10 + (text_[pos_] - '0');
+                if (value > INT32_MAX) {
+                    throw std::runtime_error("Integer out of range at offset " + std::to_string(start));
+                }
                 advance();
             }
-            return result;
+            return make(TokenType::INTEGER, start, static_cast<int>(value));
         }
 
-        Token id() {
-            std::string result;
-            while (current_char_ != '\0' && std::isalnum(current_char_)) {
-                result += current_char_;
-                advance();
+        // Ключевые слова без учёта регистра, имена - как написаны
+        static bool keyword(std::string_view word, const char* upper) {
+            size_t i = 0;
+            for (; i < word.size(); i++) {
+                if (upper[i] == '\0' || std::toupper(static_cast<unsigned char>(word[i])) != upper[i]) return false;
             }
-            std::string upper = result;
-            std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-            if (upper == "BEGIN") return {TokenType::BEGIN, result};
-            if (upper == "END") return {TokenType::END, result};
-            return {TokenType::ID, result};
+            return upper[i] == '\0';
         }
-    };
-
-    
-    class AST { public: virtual ~AST() = default; };
 
-    class BinOp : public AST {
-    public:
-        std::unique_ptr<AST> left;
-        Token op;
-        std::unique_ptr<AST> right;
-        BinOp(std::unique_ptr<AST> l, Token o, std::unique_ptr<AST> r) : left(std::move(l)), op(o), right(std::move(r)) {}
-    };
-
-    class UnaryOp : public AST {
-    public:
-        Token op;
-        std::unique_ptr<AST> expr;
-        UnaryOp(Token o, std::unique_ptr<AST> e) : op(o), expr(std::move(e)) {}
-    };
-
-    class Num : public AST {
-    public:
-        Token token;
-        int value;
-        explicit Num(Token t) : token(t), value(std::stoi(t.value)) {}
-    };
-
-    class Var : public AST {
-    public:
-        Token token;
-        std::string value;
-        explicit Var(Token t) : token(t), value(t.value) {}
-    };
-
-    class Assign : public AST {
-    public:
-        std::unique_ptr<AST> left;
-        Token op;
-        std::unique_ptr<AST> right;
-        Assign(std::unique_ptr<AST> l, Token o, std::unique_ptr<AST> r) : left(std::move(l)), op(o), right(std::move(r)) {}
+        Token id() {
+            size_t start = pos_;
+            while (pos_ < text_.size() && is_alnum(text_[pos_])) advance();
+            Token token = make(TokenType::ID, start);
+            if (keyword(token.value, "BEGIN")) token.type = TokenType::BEGIN;
+            else if (keyword(token.value, "END")) token.type = TokenType::END;
+            return token;
+        }
     };
 
-    class Compound : public AST { public: std::vector<std::unique_ptr<AST>> children; };
-    class NoOp : public AST {};
-
     
+    // Узлы дерева ссылаются на имена в исходном тексте. Вложенность
+    // скобок и блоков BEGIN/END хранится в явных стеках, а не в стеке
+    // вызовов, поэтому её глубина ограничена только памятью.
     class Parser {
     public:
-        explicit Parser(Lexer& lexer) : lexer_(lexer) { current_token_ = lexer_.get_next_token(); }
+        Parser(Lexer& lexer, Arena& arena) : lexer_(lexer), arena_(arena) { current_token_ = lexer_.get_next_token(); }
 
-        std::unique_ptr<AST> parse() {
+        AST* parse() {
             auto node = program();
             if (current_token_.type != TokenType::END_OF_FILE) {
                 throw std::runtime_error("Unexpected token after end");
@@ -165,83 +134,149 @@ namespace Pascal {
         }
 
     private:
+        // Отложенная операция разбора выражения
+        struct Pending {
+            enum Kind : uint8_t { Unary, Binary, Paren } kind;
+            TokenType op;
+        };
+
         Lexer& lexer_;
+        Arena& arena_;
         Token current_token_;
+        std::vector<AST*> operands_;
+        std::vector<Pending> pending_;
+        std::vector<AST*> statements_;      // открытые блоки подряд, границы в blocks_
+        std::vector<size_t> blocks_;
 
         void eat(TokenType type) {
             if (current_token_.type == type) current_token_ = lexer_.get_next_token();
             else throw std::runtime_error("Invalid syntax");
         }
 
-        std::unique_ptr<AST> factor() {
-            Token token = current_token_;
-            if (token.type == TokenType::PLUS) { eat(TokenType::PLUS); return std::make_unique<UnaryOp>(token, factor()); }
-            if (token.type == TokenType::MINUS) { eat(TokenType::MINUS); return std::make_unique<UnaryOp>(token, factor()); }
-            if (token.type == TokenType::INTEGER) { eat(TokenType::INTEGER); return std::make_unique<Num>(token); }
-            if (token.type == TokenType::LPAREN) { eat(TokenType::LPAREN); auto node = expr(); eat(TokenType::RPAREN); return node; }
-            if (token.type == TokenType::ID) return variable();
-            throw std::runtime_error("Unexpected token in factor");
+        static int precedence(TokenType op) {
+            return op == TokenType::MUL || op == TokenType::DIV ? 2 : 1;
+        }
+
+        static bool binary(TokenType type) {
+            return type == TokenType::PLUS || type == TokenType::MINUS || type == TokenType::MUL || type == TokenType::DIV;
         }
 
-        std::unique_ptr<AST> term() {
-            auto node = factor();
-            while (current_token_.type == TokenType::MUL || current_token_.type == TokenType::DIV) {
-                Token token = current_token_;
-                eat(token.type);
-                node = std::make_unique<BinOp>(std::move(node), token, factor());
+        // Унарный знак относится к ближайшему множителю
+        void reduce_unary(size_t base) {
+            while (pending_.size() > base && pending_.back().kind == Pending::Unary) {
+                operands_.back() = arena_.make<UnaryOp>(pending_.back().op, operands_.back());
+                pending_.pop_back();
+            }
+        }
+
+        void reduce_binary(size_t base, int min_precedence) {
+            while (pending_.size() > base && pending_.back().kind == Pending::Binary
+                   && precedence(pending_.back().op) >= min_precedence) {
+                AST* right = operands_.back();
+                operands_.pop_back();
+                operands_.back() = arena_.make<BinOp>(operands_.back(), pending_.back().op, right);
+                pending_.pop_back();
             }
-            return node;
         }
 
-        std::unique_ptr<AST> expr() {
-            auto node = term();
-            while (current_token_.type == TokenType::PLUS || current_token_.type == TokenType::MINUS) {
-                Token token = current_token_;
-                eat(token.type);
-                node = std::make_unique<BinOp>(std::move(node), token, term());
+        // expr: term ((+|-) term)*, term: factor ((*|/) factor)*,
+        // factor: (+|-) factor | INTEGER | ( expr ) | variable
+        AST* expr() {
+            size_t base = pending_.size();
+            for (;;) {
+                // ожидается множитель
+                while (current_token_.type == TokenType::PLUS || current_token_.type == TokenType::MINUS
+                       || current_token_.type == TokenType::LPAREN) {
+                    TokenType type = current_token_.type;
+                    eat(type);
+                    pending_.push_back({type == TokenType::LPAREN ? Pending::Paren : Pending::Unary, type});
+                }
+                if (current_token_.type == TokenType::INTEGER) {
+                    operands_.push_back(arena_.make<Num>(current_token_.number));
+                    eat(TokenType::INTEGER);
+                } else if (current_token_.type == TokenType::ID) {
+                    operands_.push_back(variable());
+                } else {
+                    throw std::runtime_error("Unexpected token in factor");
+                }
+                reduce_unary(base);
+
+                // после множителя: закрывающие скобки, затем операция или конец
+                while (current_token_.type == TokenType::RPAREN) {
+                    reduce_binary(base, 0);
+                    if (pending_.size() == base) break;     // скобка не наша
+                    pending_.pop_back();
+                    eat(TokenType::RPAREN);
+                    reduce_unary(base);
+                }
+                if (!binary(current_token_.type)) break;
+                TokenType op = current_token_.type;
+                reduce_binary(base, precedence(op));
+                eat(op);
+                pending_.push_back({Pending::Binary, op});
+            }
+
+            reduce_binary(base, 0);
+            if (pending_.size() != base) {
+                eat(TokenType::RPAREN);     // незакрытая скобка
             }
+            AST* node = operands_.back();
+            operands_.pop_back();
             return node;
         }
 
-        std::unique_ptr<AST> variable() {
+        Var* variable() {
             Token token = current_token_;
             eat(TokenType::ID);
-            return std::make_unique<Var>(token);
+            return arena_.make<Var>(token.value);
         }
 
-        std::unique_ptr<AST> assignment() {
+        AST* assignment() {
             auto left = variable();
-            Token token = current_token_;
             eat(TokenType::ASSIGN);
-            return std::make_unique<Assign>(std::move(left), token, expr());
-        }
-
-        std::unique_ptr<AST> statement() {
-            if (current_token_.type == TokenType::BEGIN) return compound_statement();
-            if (current_token_.type == TokenType::ID) return assignment();
-            return std::make_unique<NoOp>();
+            return arena_.make<Assign>(left, expr());
         }
 
-        std::vector<std::unique_ptr<AST>> statement_list() {
-            std::vector<std::unique_ptr<AST>> results;
-            results.push_back(statement());
-            while (current_token_.type == TokenType::SEMI) {
-                eat(TokenType::SEMI);
-                results.push_back(statement());
+        // compound: BEGIN statement (; statement)* END,
+        // statement: compound | assignment | пусто
+        AST* compound_statement() {
+            eat(TokenType::BEGIN);
+            blocks_.push_back(statements_.size());
+            for (;;) {
+                if (current_token_.type == TokenType::BEGIN) {
+                    eat(TokenType::BEGIN);
+                    blocks_.push_back(statements_.size());
+                    continue;
+                }
+                if (current_token_.type == TokenType::ID) statements_.push_back(assignment());
+                else statements_.push_back(arena_.make<NoOp>());
+
+                // конец оператора: ';' или закрытие одного или нескольких блоков
+                for (;;) {
+                    if (current_token_.type == TokenType::SEMI) {
+                        eat(TokenType::SEMI);
+                        break;
+                    }
+                    eat(TokenType::END);
+                    AST* block = close_block();
+                    if (blocks_.empty()) return block;
+                    statements_.push_back(block);
+                }
             }
-            return results;
         }
 
-        std::unique_ptr<AST> compound_statement() {
-            eat(TokenType::BEGIN);
-            auto nodes = statement_list();
-            eat(TokenType::END);
-            auto root = std::make_unique<Compound>();
-            root->children = std::move(nodes);
+        AST* close_block() {
+            size_t start = blocks_.back();
+            blocks_.pop_back();
+            auto root = arena_.make<Compound>();
+            root->count = statements_.size() - start;
+            root->children = arena_.make_array<AST*>(root->count);
+            std::copy(statements_.begin() + static_cast<std::ptrdiff_t>(start), statements_.end(), root->children);
+            statements_.resize(start);
             return root;
         }
 
-        std::unique_ptr<AST> program() {
+        AST* program() {
             auto node = compound_statement();
             eat(TokenType::DOT);
             return node;
@@ -249,71 +284,193 @@ namespace Pascal {
     };
 
     
+    enum class Mode {
+        Tree,       // обход дерева, эталон для остальных режимов
+        Bytecode,   // компиляция в байткод стековой машины
+        Jit         // байткод в машинный код x86-64; без него - как Bytecode
+    };
+
     class Interpreter {
     public:
         Interpreter() = default;
 
-        std::map<std::string, int> interpret(const std::string& code) {
+        void setMode(Mode mode) { mode_ = mode; }
+        Mode getMode() const { return mode_; }
+
+        // Свёртка констант и удаление мёртвых присваиваний перед исполнением
+        void setOptimize(bool optimize) { optimize_ = optimize; }
+        bool getOptimize() const { return optimize_; }
+
+        // Дерево разбора живёт в арене интерпретатора до следующего вызова.
+        // Переменные во время исполнения лежат в плоском массиве по ячейкам,
+        // в std::map они переводятся только для результата. stats, если
+        // передан, заполняется даже при ошибке - до фазы, где она возникла.
+        std::map<std::string, int> interpret(std::string_view code, Stats* stats = nullptr) {
             variables_.clear();
-            Lexer lexer(code);
-            Parser parser(lexer);
-            auto tree = parser.parse();
-            visit(tree.get());
-            return variables_;
-        }
+            arena_.reset();
+            symbols_.clear();
+            if (stats) {
+                stats->clear();
+                PhaseTimer timer(&stats->lex_seconds);
+                Lexer lexer(code);
+                try {
+                    while (lexer.get_next_token().type != TokenType::END_OF_FILE) stats->tokens++;
+                    stats->tokens++;
+                } catch (const std::runtime_error&) {
+                    // об ошибке сообщит разбор, как и без статистики
+                }
+            }
 
-        
-        std::map<std::string, int> variables_;
+            AST* tree;
+            {
+                PhaseTimer timer(stats ? &stats->parse_seconds : nullptr);
+                Lexer lexer(code);
+                Parser parser(lexer, arena_);
+                tree = parser.parse();
+            }
+            if (stats) {
+                stats->parse_seconds = std::max(0.0, stats->parse_seconds - stats->lex_seconds);
+                count_nodes(tree, stats->nodes);
+            }
 
-        int visit(AST* node) {
-            if (auto n = dynamic_cast<BinOp*>(node)) return visit_binop(n);
-            if (auto n = dynamic_cast<UnaryOp*>(node)) return visit_unaryop(n);
-            if (auto n = dynamic_cast<Num*>(node)) return visit_num(n);
-            if (auto n = dynamic_cast<Compound*>(node)) return visit_compound(n);
-            if (auto n = dynamic_cast<Assign*>(node)) return visit_assign(n);
-            if (auto n = dynamic_cast<Var*>(node)) return visit_var(n);
-            if (auto n = dynamic_cast<NoOp*>(node)) return visit_noop(n);
-            throw std::runtime_error("Unknown AST node");
-        }
+            {
+                PhaseTimer timer(stats ? &stats->optimize_seconds : nullptr);
+                resolver_.resolve(tree);
+                if (optimize_) tree = optimizer_.optimize(tree, symbols_.size());
+            }
+            if (stats) {
+                uint64_t executed[kNodeKinds] = {};
+                count_nodes(tree, executed);
+                stats->variables = symbols_.size();
+                stats->writes = executed[static_cast<size_t>(NodeKind::Assign)];
+                stats->reads = executed[static_cast<size_t>(NodeKind::Var)] - stats->writes;
+                stats->arena_bytes = arena_.capacity();
+            }
 
-        int visit_binop(BinOp* node) {
-            int left = visit(node->left.get());
-            int right = visit(node->right.get());
-            if (node->op.type == TokenType::PLUS) return left + right;
-            if (node->op.type == TokenType::MINUS) return left - right;
-            if (node->op.type == TokenType::MUL) return left * right;
-            if (node->op.type == TokenType::DIV) return left / right;
-            throw std::runtime_error("Unknown operator");
+            PhaseTimer timer(stats ? &stats->eval_seconds : nullptr);
+            return execute(tree, symbols_);
         }
 
-        int visit_unaryop(UnaryOp* node) {
-            int val = visit(node->expr.get());
-            if (node->op.type == TokenType::PLUS) return +val;
-            if (node->op.type == TokenType::MINUS) return -val;
-            throw std::runtime_error("Unknown unary operator");
+        // Исполнение уже разобранной программы с разрешёнными переменными
+        std::map<std::string, int> execute(AST* tree, const SymbolTable& symbols) {
+            if (mode_ == Mode::Tree) {
+                values_.assign(symbols.size(), 0);
+                defined_.assign(symbols.size(), 0);
+                visit(tree);
+                variables_ = symbols.collect(values_, defined_);
+            } else {
+                compiler_.compile(tree, symbols, chunk_);
+                variables_ = mode_ == Mode::Jit ? jit_.run(chunk_) : vm_.run(chunk_);
+            }
+            return variables_;
         }
 
-        int visit_num(Num* node) { return node->value; }
         
-        int visit_compound(Compound* node) {
-            for (const auto& child : node->children) visit(child.get());
-            return 0;
+        std::map<std::string, int> variables_;
+
+        // Обход дерева; переменные должны быть разрешены (Resolver).
+        // Каждый узел оставляет на стеке значений одно значение: выражение -
+        // результат, присваивание - присвоенное значение, блок - 0.
+        int visit(AST* root) {
+            frames_.clear();
+            stack_.clear();
+            frames_.push_back({root, 0});
+            while (!frames_.empty()) {
+                Frame& frame = frames_.back();
+                AST* node = frame.node;
+                switch (node->kind) {
+                    case NodeKind::Num:
+                        stack_.push_back(static_cast<Num*>(node)->value);
+                        frames_.pop_back();
+                        break;
+                    case NodeKind::Var:
+                        stack_.push_back(visit_var(static_cast<Var*>(node)));
+                        frames_.pop_back();
+                        break;
+                    case NodeKind::NoOp:
+                        stack_.push_back(0);
+                        frames_.pop_back();
+                        break;
+                    case NodeKind::UnaryOp: {
+                        auto unary = static_cast<UnaryOp*>(node);
+                        if (frame.state++ == 0) {
+                            frames_.push_back({unary->expr, 0});
+                            break;
+                        }
+                        stack_.back() = visit_unaryop(unary->op, stack_.back());
+                        frames_.pop_back();
+                        break;
+                    }
+                    case NodeKind::BinOp: {
+                        auto binop = static_cast<BinOp*>(node);
+                        size_t state = frame.state++;
+                        if (state < 2) {
+                            frames_.push_back({state == 0 ? binop->left : binop->right, 0});
+                            break;
+                        }
+                        int right = stack_.back();
+                        stack_.pop_back();
+                        stack_.back() = apply_binop(binop->op, stack_.back(), right);
+                        frames_.pop_back();
+                        break;
+                    }
+                    case NodeKind::Assign: {
+                        auto assign = static_cast<Assign*>(node);
+                        if (frame.state++ == 0) {
+                            frames_.push_back({assign->right, 0});
+                            break;
+                        }
+                        values_[assign->left->slot] = stack_.back();
+                        defined_[assign->left->slot] = 1;
+                        frames_.pop_back();
+                        break;
+                    }
+                    case NodeKind::Compound: {
+                        auto compound = static_cast<Compound*>(node);
+                        size_t state = frame.state++;
+                        if (state > 0) stack_.pop_back();     // значение предыдущего оператора
+                        if (state < compound->count) {
+                            frames_.push_back({compound->children[state], 0});
+                            break;
+                        }
+                        stack_.push_back(0);
+                        frames_.pop_back();
+                        break;
+                    }
+                    default:
+                        throw std::runtime_error("Unknown AST node");
+                }
+            }
+            return stack_.back();
         }
 
-        int visit_assign(Assign* node) {
-            std::string var_name = dynamic_cast<Var*>(node->left.get())->value;
-            int val = visit(node->right.get());
-            variables_[var_name] = val;
-            return val;
+        int visit_unaryop(TokenType op, int val) {
+            if (op == TokenType::PLUS) return +val;
+            if (op == TokenType::MINUS) return wrap_neg(val);
+            throw std::runtime_error("Unknown unary operator");
         }
 
         int visit_var(Var* node) {
-            std::string name = node->value;
-            if (variables_.find(name) != variables_.end()) return variables_[name];
-            throw std::runtime_error("Variable not found: " + name);
+            if (defined_[node->slot]) return values_[node->slot];
+            throw std::runtime_error("Variable not found: " + std::string(node->value));
         }
 
-        int visit_noop(NoOp*) { return 0; }
+    private:
+        Mode mode_ = Mode::Bytecode;
+        bool optimize_ = true;
+        Arena arena_;
+        SymbolTable symbols_;
+        std::vector<int> values_;
+        std::vector<char> defined_;
+        std::vector<Frame> frames_;
+        std::vector<int> stack_;
+        // Проходы и байткод хранят буферы между вызовами interpret()
+        Resolver resolver_{symbols_};
+        Optimizer optimizer_{arena_};
+        Compiler compiler_;
+        Chunk chunk_;
+        VM vm_;
+        Jit jit_;
     };
 }
 
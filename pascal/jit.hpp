@@ -0,0 +1,289 @@
+#ifndef PASCAL_JIT_HPP
+#define PASCAL_JIT_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdexcept>
+#include <initializer_list>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "bytecode.hpp"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__))
+#define PASCAL_JIT_X86_64 1
+#include <sys/mman.h>
+#endif
+
+namespace Pascal {
+
+    // Память, с которой работает машинный код. stack - место для
+    // промежуточных значений выражения, кроме верхнего.
+    struct JitContext {
+        int* slots;
+        int* stack;
+        int32_t fault;      // ячейка, прочитанная до присваивания
+    };
+
+    enum JitStatus : int {
+        JIT_OK = 0,
+        JIT_DIVISION_BY_ZERO = 1,
+        JIT_UNDEFINED = 2
+    };
+
+    // Байткод, переведённый в машинный код x86-64. Программа прямолинейна,
+    // поэтому глубина стека у каждой команды известна при компиляции:
+    // верхнее значение живёт в eax, остальные - по постоянным смещениям в
+    // JitContext::stack. По той же причине при компиляции известно, какие
+    // переменные присвоены к каждому чтению: чтение неприсвоенной сразу
+    // становится переходом на ошибку, а после успешного запуска присвоены
+    // ровно те, что есть в stored().
+    class JitCode {
+    public:
+        explicit JitCode(const Chunk& chunk) {
+            stored_.assign(chunk.names.size(), 0);
+#ifdef PASCAL_JIT_X86_64
+            Assembler a(stored_);
+            if (!a.compile(chunk)) return;
+
+            size_t length = a.bytes.size();
+            void* mem = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED) return;
+            std::memcpy(mem, a.bytes.data(), length);
+            if (mprotect(mem, length, PROT_READ | PROT_EXEC) != 0) {
+                munmap(mem, length);
+                return;
+            }
+            entry_ = mem;
+            size_ = length;
+#endif
+        }
+
+        ~JitCode() {
+#ifdef PASCAL_JIT_X86_64
+            if (entry_) munmap(entry_, size_);
+#endif
+        }
+
+        JitCode(const JitCode&) = delete;
+        JitCode& operator=(const JitCode&) = delete;
+
+        static bool available() {
+#ifdef PASCAL_JIT_X86_64
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        bool valid() const { return entry_ != nullptr; }
+
+        const std::vector<char>& stored() const { return stored_; }
+
+        int run(JitContext* ctx) const {
+            using Fn = int (*)(JitContext*);
+            return reinterpret_cast<Fn>(entry_)(ctx);
+        }
+
+    private:
+        void* entry_ = nullptr;
+        size_t size_ = 0;
+        std::vector<char> stored_;
+
+#ifdef PASCAL_JIT_X86_64
+        // rdi = контекст, r9 = ячейки, r11 = стек значений, eax = вершина стека.
+        // Вызовов наружу нет, поэтому хватает регистров, которые не нужно сохранять.
+        class Assembler {
+        public:
+            std::vector<uint8_t> bytes;
+
+            explicit Assembler(std::vector<char>& stored) : stored_(stored) {}
+
+            bool compile(const Chunk& chunk) {
+                // смещения адресуются disp32
+                if (chunk.names.size() > INT32_MAX / 4 || chunk.max_stack > INT32_MAX / 4) return false;
+                bytes.reserve(chunk.code.size() * 8 + 16);
+
+                emit({0x4C, 0x8B, 0x4F, SLOTS});            // mov r9, [rdi+slots]
+                emit({0x4C, 0x8B, 0x5F, STACK});            // mov r11, [rdi+stack]
+                size_t depth = 0;
+                for (const Instr& ins : chunk.code) {
+                    if (!instruction(ins, depth)) return false;
+                    if (ins.op == OpCode::HALT) break;
+                }
+
+                // ошибки: eax = JitStatus, для чтения без присваивания ещё и ячейка
+                size_t division_at = bytes.size();
+                emit({0xB8});                               // mov eax, JIT_DIVISION_BY_ZERO
+                emit32(JIT_DIVISION_BY_ZERO);
+                emit({0xC3});
+                std::vector<size_t> undefined_at(stored_.size(), 0);
+                for (const Fixup& f : fixups_) {
+                    if (f.slot < 0 || undefined_at[f.slot]) continue;
+                    undefined_at[f.slot] = bytes.size();
+                    emit({0xC7, 0x87});                     // mov dword [rdi+fault], slot
+                    emit32(static_cast<int32_t>(offsetof(JitContext, fault)));
+                    emit32(f.slot);
+                    emit({0xB8});                           // mov eax, JIT_UNDEFINED
+                    emit32(JIT_UNDEFINED);
+                    emit({0xC3});
+                }
+
+                for (const Fixup& f : fixups_) {
+                    size_t target = f.slot < 0 ? division_at : undefined_at[f.slot];
+                    int32_t rel = static_cast<int32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(f.at + 4));
+                    std::memcpy(&bytes[f.at], &rel, 4);
+                }
+                return true;
+            }
+
+        private:
+            enum : uint8_t { SLOTS = offsetof(JitContext, slots), STACK = offsetof(JitContext, stack) };
+
+            // Переход на ошибку; slot < 0 - деление на ноль
+            struct Fixup {
+                size_t at;
+                int32_t slot;
+            };
+
+            std::vector<char>& stored_;
+            std::vector<Fixup> fixups_;
+
+            void emit(std::initializer_list<uint8_t> code) { bytes.insert(bytes.end(), code); }
+
+            void emit32(int32_t value) {
+                uint8_t raw[4];
+                std::memcpy(raw, &value, 4);
+                bytes.insert(bytes.end(), raw, raw + 4);
+            }
+
+            // Следующие 4 байта - смещение перехода на ошибку
+            void trap(int32_t slot) {
+                fixups_.push_back({bytes.size(), slot});
+                emit32(0);
+            }
+
+            // Значение под вершиной при глубине depth
+            static int32_t spill(size_t depth) { return static_cast<int32_t>((depth - 2) * 4); }
+            static int32_t slot(int32_t index) { return index * 4; }
+
+            bool instruction(const Instr& ins, size_t& depth) {
+                switch (ins.op) {
+                    case OpCode::PUSH:
+                    case OpCode::LOAD:
+                        if (depth > 0) {
+                            emit({0x41, 0x89, 0x83});       // mov [r11+spill], eax
+                            emit32(spill(depth + 1));
+                        }
+                        if (ins.op == OpCode::PUSH) {
+                            emit({0xB8});                   // mov eax, imm32
+                            emit32(ins.arg);
+                        } else if (stored_[ins.arg]) {
+                            emit({0x41, 0x8B, 0x81});       // mov eax, [r9+slot]
+                            emit32(slot(ins.arg));
+                        } else {
+                            emit({0xE9});                   // jmp undefined
+                            trap(ins.arg);
+                        }
+                        depth++;
+                        return true;
+                    case OpCode::STORE:
+                        if (depth == 0) return false;
+                        emit({0x41, 0x89, 0x81});           // mov [r9+slot], eax
+                        emit32(slot(ins.arg));
+                        stored_[ins.arg] = 1;
+                        if (--depth > 0) {
+                            emit({0x41, 0x8B, 0x83});       // mov eax, [r11+spill]
+                            emit32(spill(depth + 1));
+                        }
+                        return true;
+                    case OpCode::ADD:
+                    case OpCode::SUB:
+                    case OpCode::MUL:
+                    case OpCode::DIV:
+                        if (depth < 2) return false;
+                        binary(ins.op, spill(depth));
+                        depth--;
+                        return true;
+                    case OpCode::NEG:
+                        if (depth == 0) return false;
+                        emit({0xF7, 0xD8});                 // neg eax
+                        return true;
+                    case OpCode::HALT:
+                        emit({0x31, 0xC0, 0xC3});           // xor eax, eax; ret
+                        return true;
+                }
+                return false;
+            }
+
+            // Левый операнд в [r11+left], правый в eax; результат в eax
+            void binary(OpCode op, int32_t left) {
+                switch (op) {
+                    case OpCode::ADD:
+                        emit({0x41, 0x03, 0x83});           // add eax, [r11+left]
+                        emit32(left);
+                        break;
+                    case OpCode::MUL:
+                        emit({0x41, 0x0F, 0xAF, 0x83});     // imul eax, [r11+left]
+                        emit32(left);
+                        break;
+                    case OpCode::SUB:
+                        emit({0x41, 0x8B, 0x8B});           // mov ecx, [r11+left]
+                        emit32(left);
+                        emit({0x29, 0xC1, 0x89, 0xC8});     // sub ecx, eax; mov eax, ecx
+                        break;
+                    default:
+                        emit({0x85, 0xC0, 0x0F, 0x84});     // test eax, eax; jz division
+                        trap(-1);
+                        emit({0x89, 0xC1});                 // mov ecx, eax
+                        emit({0x41, 0x8B, 0x83});           // mov eax, [r11+left]
+                        emit32(left);
+                        // idiv на INT_MIN / -1 падает, а делить на -1 - то же, что менять знак
+                        emit({0x83, 0xF9, 0xFF, 0x74, 0x05});   // cmp ecx, -1; je neg
+                        emit({0x99, 0xF7, 0xF9, 0xEB, 0x02});   // cdq; idiv ecx; jmp done
+                        emit({0xF7, 0xD8});                     // neg: neg eax
+                        break;
+                }
+            }
+        };
+#endif
+    };
+
+    // Исполнение байткода машинным кодом. Там, где JIT недоступен или
+    // программу не удалось перевести, работает VM.
+    class Jit {
+    public:
+        std::map<std::string, int> run(const Chunk& chunk) {
+            JitCode code(chunk);
+            if (!code.valid()) return vm_.run(chunk);
+
+            slots_.assign(chunk.names.size(), 0);
+            stack_.resize(chunk.max_stack + 1);
+            JitContext ctx{slots_.data(), stack_.data(), -1};
+            switch (code.run(&ctx)) {
+                case JIT_OK:
+                    break;
+                case JIT_DIVISION_BY_ZERO:
+                    throw std::runtime_error("Division by zero");
+                case JIT_UNDEFINED:
+                    throw std::runtime_error("Variable not found: " + chunk.names[ctx.fault]);
+                default:
+                    throw std::runtime_error("Unknown JIT status");
+            }
+
+            std::map<std::string, int> variables;
+            for (size_t i = 0; i < chunk.names.size(); i++) {
+                if (code.stored()[i]) variables.emplace(chunk.names[i], slots_[i]);
+            }
+            return variables;
+        }
+
+    private:
+        std::vector<int> slots_;
+        std::vector<int> stack_;
+        VM vm_;
+    };
+}
+
+#endif
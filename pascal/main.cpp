@@ -1,39 +1,145 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+#include <climits>
 #include "interpreter.hpp"
+#include "batch.hpp"
+#include "MappedFile.h"
+#include "CommandLine.h"
+
+// Программ со стандартного ввода в памяти одновременно; следующая порция
+// читается, когда предыдущая выведена
+static const size_t kStdinWindow = 4096;
+
+static void printResult(const std::string& name, const Pascal::BatchResult& result, bool& failed) {
+    std::cout << "==> " << name << " <==\n" << result.output;
+    if (!result.error.empty()) {
+        std::cout << "Runtime Error: " << result.error << "\n";
+        failed = true;
+    }
+}
+
+static int runFiles(Pascal::BatchRunner& runner, const std::vector<std::string>& files) {
+    bool failed = false;
+    runner.run(files.size(),
+        [&](Pascal::Interpreter& interp, size_t i) {
+            tppl::MappedFile file(files[i]);
+            if (!file.is_open()) return Pascal::BatchResult{"", "Could not open file '" + files[i] + "'"};
+            return Pascal::run_program(interp, file.view());
+        },
+        [&](size_t i, Pascal::BatchResult& result) { printResult(files[i], result, failed); });
+    std::cout.flush();
+    return failed ? 1 : 0;
+}
+
+static int runStdin(Pascal::BatchRunner& runner) {
+    bool failed = false;
+    std::vector<std::string> programs(kStdinWindow);
+    size_t base = 0;
+    try {
+        for (;;) {
+            size_t count = 0;
+            while (count < programs.size() && Pascal::read_program(std::cin, programs[count])) count++;
+            if (count == 0) break;
+            runner.run(count,
+                [&](Pascal::Interpreter& interp, size_t i) { return Pascal::run_program(interp, programs[i]); },
+                [&](size_t i, Pascal::BatchResult& result) {
+                    printResult("#" + std::to_string(base + i + 1), result, failed);
+                });
+            std::cout.flush();
+            base += count;
+            if (count < programs.size()) break;
+        }
+    } catch (const std::exception& e) {
+        std::cout.flush();
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
+
+static void printUsage(const char* progName) {
+    std::cerr << "Usage: " << progName << " [--tree | --jit] [--no-optimize] [--stats] <path_to_file>" << std::endl;
+    std::cerr << "       " << progName << " [--tree | --jit] [--no-optimize] [-j N] --batch <file>..." << std::endl;
+    std::cerr << "       " << progName << " [--tree | --jit] [--no-optimize] [-j N] --stdin" << std::endl;
+}
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <path_to_file>" << std::endl;
+    std::string filepath;
+    std::vector<std::string> batchFiles;
+    Pascal::Mode mode = Pascal::Mode::Bytecode;
+    bool optimize = true;
+    bool stats = false;
+    bool batch = false;
+    bool fromStdin = false;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--tree") mode = Pascal::Mode::Tree;
+        else if (arg == "--jit") mode = Pascal::Mode::Jit;
+        else if (arg == "--no-optimize") optimize = false;
+        else if (arg == "--stats") stats = true;
+        else if (arg == "--batch") batch = true;
+        else if (arg == "--stdin") fromStdin = true;
+        else if (arg == "-j" && i + 1 < argc) {
+            unsigned long long count = 0;
+            if (!tppl::parse_number(argv[++i], UINT_MAX, count)) {
+                std::cerr << "Error: Invalid thread count '" << argv[i] << "'" << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            threads = static_cast<unsigned>(count);
+        }
+        else if (batch) batchFiles.push_back(arg);
+        else filepath = arg;
+    }
+
+    if (batch || fromStdin) {
+        if (!filepath.empty()) batchFiles.insert(batchFiles.begin(), filepath);
+        if (batch == fromStdin || (batch && batchFiles.empty()) || stats) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        std::ios::sync_with_stdio(false);
+        Pascal::BatchRunner runner(threads, mode, optimize);
+        return batch ? runFiles(runner, batchFiles) : runStdin(runner);
+    }
+
+    if (filepath.empty()) {
+        printUsage(argv[0]);
+        std::cerr << "  --tree           evaluate by walking the syntax tree instead of the bytecode VM" << std::endl;
+        std::cerr << "  --jit            compile the bytecode to x86-64 machine code; falls back to the VM" << std::endl;
+        std::cerr << "                   where that is unavailable" << std::endl;
+        std::cerr << "  --no-optimize    skip constant folding and dead store elimination" << std::endl;
+        std::cerr << "  --stats          print phase times and node, token and variable counts to stderr" << std::endl;
+        std::cerr << "  --batch          interpret every listed file; results follow the input order," << std::endl;
+        std::cerr << "                   each after a '==> file <==' line" << std::endl;
+        std::cerr << "  --stdin          interpret programs from standard input, each written as its" << std::endl;
+        std::cerr << "                   length in bytes, a newline and the program text" << std::endl;
+        std::cerr << "  -j N             worker threads for --batch and --stdin (default: all cores)" << std::endl;
         return 1;
     }
 
-    std::string filepath = argv[1];
-    std::ifstream file(filepath);
+    tppl::MappedFile file(filepath);
     
     if (!file.is_open()) {
         std::cerr << "Error: Could not open file '" << filepath << "'" << std::endl;
         return 1;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    std::string code = buffer.str();
-
     Pascal::Interpreter interp;
+    interp.setMode(mode);
+    interp.setOptimize(optimize);
+    Pascal::Stats report;
     try {
-        auto variables = interp.interpret(code);
+        auto variables = interp.interpret(file.view(), stats ? &report : nullptr);
+        if (stats) report.report(std::cerr);
         
-        if (variables.empty()) {
-            std::cout << "No variables defined." << std::endl;
-        } else {
-            std::cout << "Variables:" << std::endl;
-            for (const auto& pair : variables) {
-                std::cout << pair.first << " = " << pair.second << std::endl;
-            }
-        }
+        Pascal::print_variables(std::cout, variables);
     } catch (const std::exception& e) {
+        if (stats) report.report(std::cerr);
         std::cerr << "Runtime Error: " << e.what() << std::endl;
         return 1;
     }
@@ -0,0 +1,206 @@
+#ifndef PASCAL_OPTIMIZER_HPP
+#define PASCAL_OPTIMIZER_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "ast.hpp"
+
+namespace Pascal {
+
+    // Упрощение программы с разрешёнными переменными (см. Resolver).
+    // Программа - прямая последовательность присваиваний, поэтому:
+    // - константные подвыражения сворачиваются, значения переменных,
+    //   известные при компиляции, подставляются вместо чтения;
+    // - присваивание удаляется, если значение перезаписывается раньше,
+    //   чем прочитано, и его вычисление не может завершиться ошибкой.
+    // Деление на ноль и чтение неприсвоенной переменной остаются в коде,
+    // так что ошибка возникает в том же месте, что и без оптимизации.
+    // Результат - один Compound со всеми оставшимися присваиваниями.
+    class Optimizer {
+    public:
+        explicit Optimizer(Arena& arena) : arena_(arena) {}
+
+        AST* optimize(AST* root, size_t slots) {
+            statements_.clear();
+            safe_.clear();
+            known_.assign(slots, 0);
+            value_.assign(slots, 0);
+            defined_.assign(slots, 0);
+            flatten(root);
+
+            for (Assign*& assign : statements_) {
+                bool safe = true;
+                AST* right = fold(assign->right, safe);
+                if (right != assign->right) assign = arena_.make<Assign>(assign->left, right);
+                safe_.push_back(safe);
+
+                int32_t slot = assign->left->slot;
+                known_[slot] = right->kind == NodeKind::Num;
+                if (known_[slot]) value_[slot] = static_cast<Num*>(right)->value;
+                defined_[slot] = 1;
+            }
+
+            eliminate_dead_stores(slots);
+
+            auto compound = arena_.make<Compound>();
+            compound->children = arena_.make_array<AST*>(statements_.size());
+            compound->count = statements_.size();
+            std::copy(statements_.begin(), statements_.end(), compound->children);
+            return compound;
+        }
+
+    private:
+        Arena& arena_;
+        std::vector<Assign*> statements_;
+        std::vector<char> safe_;
+        std::vector<char> known_;
+        std::vector<int> value_;
+        std::vector<char> defined_;
+        std::vector<Frame> frames_;
+        std::vector<AST*> folded_;     // свёрнутые поддеревья
+        std::vector<AST*> pending_;
+        std::vector<char> overwritten_;
+        std::vector<char> keep_;
+
+        void flatten(AST* root) {
+            frames_.clear();
+            frames_.push_back({root, 0});
+            while (!frames_.empty()) {
+                Frame& frame = frames_.back();
+                if (frame.node->kind != NodeKind::Compound) {
+                    if (frame.node->kind == NodeKind::Assign) statements_.push_back(static_cast<Assign*>(frame.node));
+                    frames_.pop_back();
+                    continue;
+                }
+                auto compound = static_cast<Compound*>(frame.node);
+                if (frame.state < compound->count) frames_.push_back({compound->children[frame.state++], 0});
+                else frames_.pop_back();
+            }
+        }
+
+        // safe сбрасывается, если вычисление может завершиться ошибкой
+        AST* fold(AST* root, bool& safe) {
+            frames_.clear();
+            folded_.clear();
+            frames_.push_back({root, 0});
+            while (!frames_.empty()) {
+                Frame& frame = frames_.back();
+                AST* node = frame.node;
+                size_t state = frame.state++;
+                if (node->kind == NodeKind::UnaryOp && state == 0) {
+                    frames_.push_back({static_cast<UnaryOp*>(node)->expr, 0});
+                    continue;
+                }
+                if (node->kind == NodeKind::BinOp && state < 2) {
+                    auto binop = static_cast<BinOp*>(node);
+                    frames_.push_back({state == 0 ? binop->left : binop->right, 0});
+                    continue;
+                }
+                frames_.pop_back();
+                folded_.push_back(fold_node(node, safe));
+            }
+            return folded_.back();
+        }
+
+        // Дети узла уже свёрнуты и лежат на вершине folded_
+        AST* fold_node(AST* node, bool& safe) {
+            switch (node->kind) {
+                case NodeKind::Num:
+                    return node;
+                case NodeKind::Var: {
+                    int32_t slot = static_cast<Var*>(node)->slot;
+                    if (known_[slot]) return arena_.make<Num>(value_[slot]);
+                    if (!defined_[slot]) safe = false;
+                    return node;
+                }
+                case NodeKind::UnaryOp: {
+                    auto unary = static_cast<UnaryOp*>(node);
+                    AST* expr = folded_.back();
+                    folded_.pop_back();
+                    if (unary->op != TokenType::PLUS && unary->op != TokenType::MINUS) {
+                        safe = false;
+                        return node;
+                    }
+                    if (expr->kind == NodeKind::Num) {
+                        int value = static_cast<Num*>(expr)->value;
+                        return arena_.make<Num>(unary->op == TokenType::MINUS ? wrap_neg(value) : value);
+                    }
+                    return expr == unary->expr ? node : arena_.make<UnaryOp>(unary->op, expr);
+                }
+                case NodeKind::BinOp: {
+                    auto binop = static_cast<BinOp*>(node);
+                    AST* right = folded_.back();
+                    folded_.pop_back();
+                    AST* left = folded_.back();
+                    folded_.pop_back();
+                    bool known_divisor = right->kind == NodeKind::Num && static_cast<Num*>(right)->value != 0;
+                    if (binop->op == TokenType::DIV && !known_divisor) safe = false;
+                    bool arithmetic = binop->op == TokenType::PLUS || binop->op == TokenType::MINUS
+                        || binop->op == TokenType::MUL || binop->op == TokenType::DIV;
+                    if (!arithmetic) {
+                        safe = false;
+                        return node;
+                    }
+                    if (left->kind == NodeKind::Num && right->kind == NodeKind::Num
+                        && (binop->op != TokenType::DIV || known_divisor)) {
+                        int a = static_cast<Num*>(left)->value;
+                        int b = static_cast<Num*>(right)->value;
+                        return arena_.make<Num>(apply_binop(binop->op, a, b));
+                    }
+                    if (left == binop->left && right == binop->right) return node;
+                    return arena_.make<BinOp>(left, binop->op, right);
+                }
+                default:
+                    safe = false;
+                    return node;
+            }
+        }
+
+        // Обратный проход: overwritten - переменная будет перезаписана
+        // раньше, чем прочитана
+        void eliminate_dead_stores(size_t slots) {
+            std::vector<char>& overwritten = overwritten_;
+            std::vector<char>& keep = keep_;
+            overwritten.assign(slots, 0);
+            keep.assign(statements_.size(), 1);
+            for (size_t i = statements_.size(); i-- > 0; ) {
+                Assign* assign = statements_[i];
+                int32_t slot = assign->left->slot;
+                if (overwritten[slot] && safe_[i]) {
+                    keep[i] = 0;
+                    continue;
+                }
+                overwritten[slot] = 1;
+                mark_reads(assign->right, overwritten);
+            }
+
+            size_t kept = 0;
+            for (size_t i = 0; i < statements_.size(); i++) {
+                if (keep[i]) statements_[kept++] = statements_[i];
+            }
+            statements_.resize(kept);
+        }
+
+        void mark_reads(AST* root, std::vector<char>& overwritten) {
+            std::vector<AST*>& pending = pending_;
+            pending.clear();
+            pending.push_back(root);
+            while (!pending.empty()) {
+                AST* node = pending.back();
+                pending.pop_back();
+                switch (node->kind) {
+                    case NodeKind::Var: overwritten[static_cast<Var*>(node)->slot] = 0; break;
+                    case NodeKind::UnaryOp: pending.push_back(static_cast<UnaryOp*>(node)->expr); break;
+                    case NodeKind::BinOp:
+                        pending.push_back(static_cast<BinOp*>(node)->left);
+                        pending.push_back(static_cast<BinOp*>(node)->right);
+                        break;
+                    default: break;
+                }
+            }
+        }
+    };
+}
+
+#endif
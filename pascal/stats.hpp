@@ -0,0 +1,116 @@
+#ifndef PASCAL_STATS_HPP
+#define PASCAL_STATS_HPP
+
+#include <ostream>
+#include <chrono>
+#include <utility>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include "ast.hpp"
+
+namespace Pascal {
+
+    constexpr size_t kNodeKinds = static_cast<size_t>(NodeKind::NoOp) + 1;
+
+    inline const char* node_kind_name(NodeKind kind) {
+        static const char* names[kNodeKinds] = {"BinOp", "UnaryOp", "Num", "Var", "Assign", "Compound", "NoOp"};
+        size_t index = static_cast<size_t>(kind);
+        return index < kNodeKinds ? names[index] : "?";
+    }
+
+    // Что стоил последний interpret(). Заполняется, только если передан в
+    // interpret(); без него интерпретатор не читает часы и ничего не считает.
+    struct Stats {
+        double lex_seconds = 0;         // отдельный проход лексера
+        double parse_seconds = 0;       // разбор без времени лексера
+        double optimize_seconds = 0;    // разрешение переменных и оптимизация
+        double eval_seconds = 0;        // компиляция и исполнение
+        uint64_t tokens = 0;            // включая конец текста
+        uint64_t nodes[kNodeKinds] = {};
+        uint64_t variables = 0;         // разных имён
+        // Программа прямолинейна: успешный запуск выполняет каждое
+        // оставшееся после оптимизации чтение и присваивание ровно раз
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+        size_t arena_bytes = 0;
+
+        void clear() { *this = Stats(); }
+
+        uint64_t total_nodes() const {
+            uint64_t total = 0;
+            for (uint64_t n : nodes) total += n;
+            return total;
+        }
+
+        void report(std::ostream& out) const {
+            char line[128];
+            out << "Phase times:\n";
+            const std::pair<const char*, double> phases[] = {
+                {"lex", lex_seconds}, {"parse", parse_seconds}, {"optimize", optimize_seconds}, {"evaluate", eval_seconds}
+            };
+            for (const auto& phase : phases) {
+                std::snprintf(line, sizeof(line), "  %-10s %12.3f ms\n", phase.first, phase.second * 1e3);
+                out << line;
+            }
+            out << "Tokens: " << tokens << "\n";
+            out << "Nodes: " << total_nodes() << " (";
+            for (size_t i = 0; i < kNodeKinds; i++) {
+                out << (i ? ", " : "") << node_kind_name(static_cast<NodeKind>(i)) << " " << nodes[i];
+            }
+            out << ")\n";
+            out << "Variables: " << variables << ", reads: " << reads << ", writes: " << writes << "\n";
+            out << "Arena: " << arena_bytes / 1024 << " KB\n";
+        }
+    };
+
+    // Прибавляет время жизни к *target; с nullptr часы не читаются
+    class PhaseTimer {
+    public:
+        explicit PhaseTimer(double* target) : target_(target) {
+            if (target_) begin_ = std::chrono::steady_clock::now();
+        }
+
+        ~PhaseTimer() {
+            if (target_) *target_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_).count();
+        }
+
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    private:
+        double* target_;
+        std::chrono::steady_clock::time_point begin_;
+    };
+
+    // Число узлов каждого вида в дереве
+    inline void count_nodes(AST* root, uint64_t (&counts)[kNodeKinds]) {
+        std::vector<AST*> pending{root};
+        while (!pending.empty()) {
+            AST* node = pending.back();
+            pending.pop_back();
+            size_t index = static_cast<size_t>(node->kind);
+            if (index < kNodeKinds) counts[index]++;
+            switch (node->kind) {
+                case NodeKind::BinOp:
+                    pending.push_back(static_cast<BinOp*>(node)->left);
+                    pending.push_back(static_cast<BinOp*>(node)->right);
+                    break;
+                case NodeKind::UnaryOp:
+                    pending.push_back(static_cast<UnaryOp*>(node)->expr);
+                    break;
+                case NodeKind::Assign:
+                    pending.push_back(static_cast<Assign*>(node)->left);
+                    pending.push_back(static_cast<Assign*>(node)->right);
+                    break;
+                case NodeKind::Compound:
+                    for (AST* child : *static_cast<Compound*>(node)) pending.push_back(child);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+#endif
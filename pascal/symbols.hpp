@@ -0,0 +1,98 @@
+#ifndef PASCAL_SYMBOLS_HPP
+#define PASCAL_SYMBOLS_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstdint>
+#include "ast.hpp"
+
+namespace Pascal {
+
+    // Имена переменных программы; номер имени - ячейка в плоском массиве
+    class SymbolTable {
+    public:
+        int32_t intern(std::string_view name) {
+            auto it = index_.find(name);
+            if (it != index_.end()) return it->second;
+            int32_t slot = static_cast<int32_t>(names_.size());
+            names_.push_back(name);
+            index_.emplace(name, slot);
+            return slot;
+        }
+
+        size_t size() const { return names_.size(); }
+        std::string_view name(int32_t slot) const { return names_[static_cast<size_t>(slot)]; }
+
+        void clear() {
+            names_.clear();
+            index_.clear();
+        }
+
+        // Значения присвоенных переменных в виде результата interpret()
+        std::map<std::string, int> collect(const std::vector<int>& values, const std::vector<char>& defined) const {
+            std::map<std::string, int> variables;
+            for (size_t i = 0; i < names_.size(); i++) {
+                if (defined[i]) variables.emplace(std::string(names_[i]), values[i]);
+            }
+            return variables;
+        }
+
+    private:
+        std::vector<std::string_view> names_;
+        std::unordered_map<std::string_view, int32_t> index_;
+    };
+
+    // Раздаёт ячейки всем Var дерева в порядке первого упоминания
+    class Resolver {
+    public:
+        explicit Resolver(SymbolTable& symbols) : symbols_(symbols) {}
+
+        void resolve(AST* root) {
+            pending_.clear();
+            pending_.push_back(root);
+            while (!pending_.empty()) {
+                AST* node = pending_.back();
+                pending_.pop_back();
+                // дети кладутся в обратном порядке, чтобы обходиться слева направо
+                switch (node->kind) {
+                    case NodeKind::BinOp:
+                        pending_.push_back(static_cast<BinOp*>(node)->right);
+                        pending_.push_back(static_cast<BinOp*>(node)->left);
+                        break;
+                    case NodeKind::UnaryOp:
+                        pending_.push_back(static_cast<UnaryOp*>(node)->expr);
+                        break;
+                    case NodeKind::Var: {
+                        auto var = static_cast<Var*>(node);
+                        var->slot = symbols_.intern(var->value);
+                        break;
+                    }
+                    case NodeKind::Assign:
+                        pending_.push_back(static_cast<Assign*>(node)->right);
+                        pending_.push_back(static_cast<Assign*>(node)->left);
+                        break;
+                    case NodeKind::Compound: {
+                        auto compound = static_cast<Compound*>(node);
+                        for (size_t i = compound->count; i-- > 0; ) pending_.push_back(compound->children[i]);
+                        break;
+                    }
+                    case NodeKind::Num:
+                    case NodeKind::NoOp:
+                        break;
+                    default:
+                        throw std::runtime_error("Unknown AST node");
+                }
+            }
+        }
+
+    private:
+        SymbolTable& symbols_;
+        std::vector<AST*> pending_;
+    };
+}
+
+#endif
@@ -1,7 +1,11 @@
 #include <gtest/gtest.h>
 #include <string>
 #include <memory>
+#include <map>
+#include <sstream>
+#include <cstdint>
 #include "interpreter.hpp"
+#include "batch.hpp"
 
 using namespace Pascal;
 
@@ -62,6 +66,51 @@ TEST(LexerTest, PeekColonBoundary) {
     EXPECT_THROW(l.get_next_token(), std::runtime_error);
 }
 
+TEST(LexerTest, TokensAreSourceSlices) {
+    std::string code = "begin Xy1 :=  42 ;End.";
+    Lexer l(code);
+    Token t = l.get_next_token();
+    EXPECT_EQ(t.type, TokenType::BEGIN);
+    EXPECT_EQ(t.value, "begin");
+    EXPECT_EQ(t.value.data(), code.data());
+    t = l.get_next_token();
+    EXPECT_EQ(t.type, TokenType::ID);
+    EXPECT_EQ(t.value, "Xy1");
+    EXPECT_EQ(t.pos, 6u);
+    EXPECT_EQ(l.get_next_token().type, TokenType::ASSIGN);
+    t = l.get_next_token();
+    EXPECT_EQ(t.type, TokenType::INTEGER);
+    EXPECT_EQ(t.number, 42);
+    EXPECT_EQ(t.pos, 14u);
+    EXPECT_EQ(l.get_next_token().type, TokenType::SEMI);
+    EXPECT_EQ(l.get_next_token().type, TokenType::END);
+    EXPECT_EQ(l.get_next_token().type, TokenType::DOT);
+    EXPECT_EQ(l.get_next_token().type, TokenType::END_OF_FILE);
+}
+
+TEST(LexerTest, KeywordsIgnoreCase) {
+    Lexer l("bEgIn BEGINS en END");
+    EXPECT_EQ(l.get_next_token().type, TokenType::BEGIN);
+    EXPECT_EQ(l.get_next_token().type, TokenType::ID);
+    EXPECT_EQ(l.get_next_token().type, TokenType::ID);
+    EXPECT_EQ(l.get_next_token().type, TokenType::END);
+}
+
+TEST(LexerTest, IntegerRange) {
+    Interpreter interp;
+    EXPECT_EQ(interp.interpret("BEGIN x := 2147483647 END.").at("x"), 2147483647);
+    EXPECT_THROW(interp.interpret("BEGIN x := 2147483648 END."), std::runtime_error);
+    EXPECT_THROW(interp.interpret("BEGIN x := 99999999999999999999 END."), std::runtime_error);
+}
+
+// Текст не обязан заканчиваться нулём
+TEST(LexerTest, SourceView) {
+    std::string buffer = "BEGIN x := 12 END.BEGIN x := 3";
+    Interpreter interp;
+    auto result = interp.interpret(std::string_view(buffer).substr(0, 18));
+    EXPECT_EQ(result.at("x"), 12);
+}
+
 // Тесты на Парсер
 
 TEST(ParserTest, GarbageAfterDot) {
@@ -88,14 +137,11 @@ TEST(InterpreterTest, UninitializedVariable) {
 
 TEST(InterpreterTest, UnknownBinOp) {
     Interpreter interp;
-    auto left = std::make_unique<Num>(Token{TokenType::INTEGER, "1"});
-    auto right = std::make_unique<Num>(Token{TokenType::INTEGER, "1"});
-    Token badOp{TokenType::DOT, "."};
-    
-    auto node = std::make_unique<BinOp>(std::move(left), badOp, std::move(right));
+    Arena arena;
+    auto node = arena.make<BinOp>(arena.make<Num>(1), TokenType::DOT, arena.make<Num>(1));
     
     try {
-        interp.visit(node.get());
+        interp.visit(node);
         FAIL() << "Expected std::runtime_error";
     } catch(const std::runtime_error& e) {
         EXPECT_EQ(std::string(e.what()), "Unknown operator");
@@ -104,13 +150,11 @@ TEST(InterpreterTest, UnknownBinOp) {
 
 TEST(InterpreterTest, UnknownUnaryOp) {
     Interpreter interp;
-    auto expr = std::make_unique<Num>(Token{TokenType::INTEGER, "1"});
-    Token badOp{TokenType::MUL, "*"};
-    
-    auto node = std::make_unique<UnaryOp>(badOp, std::move(expr));
+    Arena arena;
+    auto node = arena.make<UnaryOp>(TokenType::MUL, arena.make<Num>(1));
     
     try {
-        interp.visit(node.get());
+        interp.visit(node);
         FAIL() << "Expected std::runtime_error";
     } catch(const std::runtime_error& e) {
         EXPECT_EQ(std::string(e.what()), "Unknown unary operator");
@@ -118,9 +162,8 @@ TEST(InterpreterTest, UnknownUnaryOp) {
 }
 
 TEST(InterpreterTest, UnknownASTNode) {
-    class UnknownNode : public AST {};
     Interpreter interp;
-    UnknownNode node;
+    AST node(static_cast<NodeKind>(0xff));
     
     try {
         interp.visit(&node);
@@ -130,10 +173,469 @@ TEST(InterpreterTest, UnknownASTNode) {
     }
 }
 
-// Тесты жизненного цикла AST
+// Повторный запуск на том же интерпретаторе не видит старых переменных
+TEST(InterpreterTest, ReusedInterpreter) {
+    Interpreter interp;
+    EXPECT_EQ(interp.interpret("BEGIN x := 1; y := x + 1 END.").size(), 2u);
+    auto result = interp.interpret("BEGIN z := 5 END.");
+    EXPECT_EQ(result.size(), 1u);
+    EXPECT_EQ(result.at("z"), 5);
+    EXPECT_THROW(interp.interpret("BEGIN a := x END."), std::runtime_error);
+}
+
+// Ячейки переменных
+
+TEST(ResolverTest, SlotsInFirstMentionOrder) {
+    Arena arena;
+    Lexer lexer("BEGIN b := 1; a := b; BEGIN b := a + c END END.");
+    Parser parser(lexer, arena);
+    AST* tree = parser.parse();
+    SymbolTable symbols;
+    Resolver(symbols).resolve(tree);
+    ASSERT_EQ(symbols.size(), 3u);
+    EXPECT_EQ(symbols.name(0), "b");
+    EXPECT_EQ(symbols.name(1), "a");
+    EXPECT_EQ(symbols.name(2), "c");
+    EXPECT_EQ(symbols.intern("a"), 1);
+}
+
+TEST(ResolverTest, ManyVariables) {
+    std::string code = "BEGIN v0 := 1";
+    for (int k = 1; k < 5000; k++) code += "; v" + std::to_string(k) + " := v" + std::to_string(k - 1) + " + 1";
+    code += " END.";
+    for (Mode mode : {Mode::Tree, Mode::Bytecode, Mode::Jit}) {
+        Interpreter interp;
+        interp.setMode(mode);
+        auto result = interp.interpret(code);
+        ASSERT_EQ(result.size(), 5000u);
+        EXPECT_EQ(result.at("v0"), 1);
+        EXPECT_EQ(result.at("v4999"), 5000);
+    }
+}
+
+// Имена чувствительны к регистру, как и раньше
+TEST(ResolverTest, CaseSensitiveNames) {
+    Interpreter interp;
+    auto result = interp.interpret("BEGIN x := 1; X := 2 END.");
+    EXPECT_EQ(result.at("x"), 1);
+    EXPECT_EQ(result.at("X"), 2);
+}
+
+// Тесты арены
+
+TEST(ArenaTest, AlignmentAndLargeAllocations) {
+    Arena arena(64);
+    char* c = arena.make<char>('a');
+    int64_t* i = arena.make<int64_t>(7);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(i) % alignof(int64_t), 0u);
+    EXPECT_EQ(*c, 'a');
+    EXPECT_EQ(*i, 7);
+
+    AST** big = arena.make_array<AST*>(1000);
+    for (size_t k = 0; k < 1000; k++) EXPECT_EQ(big[k], nullptr);
+    EXPECT_EQ(arena.copy("name"), "name");
+    EXPECT_EQ(arena.make_array<AST*>(0), nullptr);
+}
+
+TEST(ArenaTest, ResetReusesBlocks) {
+    Arena arena(1024);
+    for (int k = 0; k < 1000; k++) arena.make<Num>(k);
+    size_t capacity = arena.capacity();
+    for (int round = 0; round < 10; round++) {
+        arena.reset();
+        for (int k = 0; k < 1000; k++) EXPECT_EQ(arena.make<Num>(k)->value, k);
+    }
+    EXPECT_EQ(arena.capacity(), capacity);
+}
+
+TEST(ArenaTest, LargeProgram) {
+    std::string code = "BEGIN x := 0";
+    for (int k = 0; k < 20000; k++) code += "; x := x + " + std::to_string(k % 7);
+    code += " END.";
+    Interpreter interp;
+    int expected = 0;
+    for (int k = 0; k < 20000; k++) expected += k % 7;
+    EXPECT_EQ(interp.interpret(code).at("x"), expected);
+    EXPECT_EQ(interp.interpret(code).at("x"), expected);
+}
+
+// Байткод против обхода дерева: одинаковые переменные или одинаковая ошибка
+
+struct RunResult {
+    std::map<std::string, int> variables;
+    std::string error;
+};
+
+static RunResult runInMode(Mode mode, const std::string& code, bool optimize = true) {
+    Interpreter interp;
+    interp.setMode(mode);
+    interp.setOptimize(optimize);
+    RunResult result;
+    try {
+        result.variables = interp.interpret(code);
+    } catch (const std::runtime_error& e) {
+        result.error = e.what();
+    }
+    return result;
+}
+
+// Эталон - обход неоптимизированного дерева
+static void expectSameAsTree(const std::string& code) {
+    RunResult tree = runInMode(Mode::Tree, code, false);
+    for (Mode mode : {Mode::Tree, Mode::Bytecode, Mode::Jit}) {
+        for (bool optimize : {false, true}) {
+            RunResult result = runInMode(mode, code, optimize);
+            EXPECT_EQ(result.variables, tree.variables) << code;
+            EXPECT_EQ(result.error, tree.error) << code;
+        }
+    }
+}
+
+TEST(BytecodeTest, Examples) {
+    expectSameAsTree("BEGIN END.");
+    expectSameAsTree("BEGIN x:= 2 + 3 * (2 + 3); y:= 2 / 2 - 2 + 3 * ((1 + 1) + (1 + 1)); END.");
+    expectSameAsTree("BEGIN y: = 2; BEGIN a := 3; a := a; b := 10 + a + 10 * y / 4; c := a - b END; x := 11; END.");
+    expectSameAsTree("BEGIN x := - - + -7; y := -x * -(x - 1) END.");
+}
+
+TEST(BytecodeTest, Errors) {
+    expectSameAsTree("BEGIN x := y + 1; END.");
+    expectSameAsTree("BEGIN x := 1; y := x / (x - 1) END.");
+    expectSameAsTree("BEGIN x := 1 / 0 + z END.");
+    expectSameAsTree("BEGIN x := z + 1 / 0 END.");
+    EXPECT_EQ(runInMode(Mode::Bytecode, "BEGIN x := 7 / (3 - 3) END.").error, "Division by zero");
+}
+
+TEST(BytecodeTest, Overflow) {
+    expectSameAsTree("BEGIN x := 2147483647 + 1; y := 0 - 2147483647 - 1; z := y / -1; w := y * -1; v := -y END.");
+    auto result = runInMode(Mode::Bytecode, "BEGIN x := 2147483647 + 1; y := x / -1 END.").variables;
+    EXPECT_EQ(result.at("x"), INT32_MIN);
+    EXPECT_EQ(result.at("y"), INT32_MIN);
+}
+
+// Машинный код
+
+TEST(JitTest, CompilesWhereAvailable) {
+    Arena arena;
+    Lexer lexer("BEGIN x := 1; y := x * 2 END.");
+    Parser parser(lexer, arena);
+    AST* tree = parser.parse();
+    SymbolTable symbols;
+    Resolver(symbols).resolve(tree);
+    Chunk chunk = Compiler().compile(tree, symbols);
+    JitCode code(chunk);
+    EXPECT_EQ(code.valid(), JitCode::available());
+    auto result = Jit().run(chunk);
+    EXPECT_EQ(result.at("y"), 2);
+}
+
+// Без оптимизации деление и чтения доходят до машинного кода
+TEST(JitTest, Division) {
+    expectSameAsTree("BEGIN a := 7; b := 0 - 2; q := a / b; r := -a / b; s := a / -a; t := (0 - a) / 2 END.");
+    expectSameAsTree("BEGIN m := 0 - 2147483647 - 1; n := m / -1; k := m / 1; l := m / m; j := 1 / m END.");
+    expectSameAsTree("BEGIN a := 1; b := a / (a - 1) + c END.");
+    expectSameAsTree("BEGIN a := 1; b := c + a / (a - 1) END.");
+    EXPECT_EQ(runInMode(Mode::Jit, "BEGIN a := 3; x := 7 / (a - 3) END.", false).error, "Division by zero");
+}
+
+TEST(JitTest, UndefinedVariables) {
+    expectSameAsTree("BEGIN x := x + 1 END.");
+    expectSameAsTree("BEGIN a := 2; BEGIN b := a * (c - 1) END; c := 3 END.");
+    EXPECT_EQ(runInMode(Mode::Jit, "BEGIN a := 1; b := a + c END.", false).error, "Variable not found: c");
+}
+
+// Результат одного запуска не виден следующему
+TEST(JitTest, ReusedInterpreter) {
+    Interpreter interp;
+    interp.setMode(Mode::Jit);
+    interp.setOptimize(false);
+    EXPECT_EQ(interp.interpret("BEGIN x := 4; y := x * x END.").at("y"), 16);
+    EXPECT_THROW(interp.interpret("BEGIN z := x END."), std::runtime_error);
+    auto result = interp.interpret("BEGIN x := 9 END.");
+    EXPECT_EQ(result.size(), 1u);
+    EXPECT_EQ(result.at("x"), 9);
+}
+
+// Случайные программы из детерминированного генератора
+class ProgramGenerator {
+public:
+    explicit ProgramGenerator(uint32_t seed) : state_(seed) {}
+
+    std::string program(int statements) {
+        // большинство переменных определено заранее, иначе почти каждая
+        // программа заканчивается ошибкой
+        std::string code = "BEGIN\n";
+        for (char v = 'a'; v < 'f'; v++) code += std::string(1, v) + " := " + std::to_string(1 + next(50)) + ";\n";
+        for (int i = 0; i < statements; i++) {
+            if (i > 0) code += ";\n";
+            if (next(8) == 0) code += "BEGIN " + assignment() + "; " + assignment() + " END";
+            else code += assignment();
+        }
+        return code + "\nEND.";
+    }
 
-TEST(ASTLifeCycle, Destructors) {
-    { std::unique_ptr<AST> node = std::make_unique<NoOp>(); }
-    { std::unique_ptr<AST> node = std::make_unique<Num>(Token{TokenType::INTEGER, "1"}); }
-    { std::unique_ptr<AST> node = std::make_unique<Var>(Token{TokenType::ID, "x"}); }
-}
\ No newline at end of file
+private:
+    uint32_t state_;
+
+    uint32_t next(uint32_t bound) {
+        state_ = state_ * 1664525u + 1013904223u;
+        return (state_ >> 8) % bound;
+    }
+
+    std::string name() { return std::string(1, static_cast<char>('a' + next(6))); }
+
+    std::string assignment() { return name() + " := " + expression(4); }
+
+    std::string expression(int depth) {
+        if (depth == 0 || next(3) == 0) {
+            return next(2) == 0 ? std::to_string(next(100)) : name();
+        }
+        static const char* ops[] = {" + ", " - ", " * ", " / "};
+        switch (next(4)) {
+            case 0: return "-" + expression(depth - 1);
+            case 1: return "(" + expression(depth - 1) + ")";
+            default: return expression(depth - 1) + ops[next(4)] + expression(depth - 1);
+        }
+    }
+};
+
+TEST(BytecodeTest, RandomPrograms) {
+    for (uint32_t seed = 1; seed <= 300; seed++) {
+        expectSameAsTree(ProgramGenerator(seed).program(1 + static_cast<int>(seed % 20)));
+    }
+}
+
+// Оптимизатор
+
+static Compound* optimized(Arena& arena, const std::string& code) {
+    Lexer lexer(code);
+    Parser parser(lexer, arena);
+    AST* tree = parser.parse();
+    SymbolTable symbols;
+    Resolver(symbols).resolve(tree);
+    AST* result = Optimizer(arena).optimize(tree, symbols.size());
+    EXPECT_EQ(result->kind, NodeKind::Compound);
+    return static_cast<Compound*>(result);
+}
+
+TEST(OptimizerTest, FoldsConstants) {
+    Arena arena;
+    std::string code = "BEGIN x := 2 * (3 + 4) - -1; BEGIN y := x / 3 + z END END.";
+    Compound* program = optimized(arena, code);
+    ASSERT_EQ(program->count, 2u);
+    auto x = static_cast<Assign*>(program->children[0]);
+    ASSERT_EQ(x->right->kind, NodeKind::Num);
+    EXPECT_EQ(static_cast<Num*>(x->right)->value, 15);
+    // z не присвоена - чтение остаётся и даёт ошибку при исполнении
+    auto y = static_cast<Assign*>(program->children[1]);
+    EXPECT_EQ(y->right->kind, NodeKind::BinOp);
+    expectSameAsTree(code);
+}
+
+TEST(OptimizerTest, RemovesDeadStores) {
+    Arena arena;
+    std::string code = "BEGIN a := 1; b := a + 1; a := 5; c := d; a := 7; b := b * 2 END.";
+    Compound* program = optimized(arena, code);
+    // a := 1 и a := 5 не видны, b := a + 1 свернулось в 2 и перезаписано
+    ASSERT_EQ(program->count, 3u);
+    EXPECT_EQ(static_cast<Assign*>(program->children[0])->left->value, "c");
+    EXPECT_EQ(static_cast<Assign*>(program->children[1])->left->value, "a");
+    EXPECT_EQ(static_cast<Assign*>(program->children[2])->left->value, "b");
+    expectSameAsTree(code);
+}
+
+TEST(OptimizerTest, KeepsRuntimeErrors) {
+    expectSameAsTree("BEGIN x := 1 / 0; x := 2 END.");
+    expectSameAsTree("BEGIN x := 1; y := 5 / (x - 1); y := 3 END.");
+    expectSameAsTree("BEGIN x := q; x := 2 END.");
+    expectSameAsTree("BEGIN x := 1 / 0 + q END.");
+    expectSameAsTree("BEGIN x := q + 1 / 0 END.");
+    expectSameAsTree("BEGIN a := 3; b := a / (a - 3) * 0; b := 1 END.");
+}
+
+TEST(OptimizerTest, UnknownValues) {
+    // значение x не известно, но x присвоена - чтение безопасно
+    expectSameAsTree("BEGIN x := 1; y := 0; BEGIN x := x / y END; x := 4 END.");
+    expectSameAsTree("BEGIN x := 6; y := 2; z := x / y; x := z * z; y := x - z END.");
+    expectSameAsTree("BEGIN x := 2147483647; x := x + 1; y := -x; z := x / -1 END.");
+}
+
+// Глубокая вложенность: разбор и исполнение не используют стек вызовов
+
+static const int kDeep = 100000;
+
+static void expectDeep(const std::string& code, const std::string& name, int value) {
+    for (Mode mode : {Mode::Tree, Mode::Bytecode, Mode::Jit}) {
+        for (bool optimize : {false, true}) {
+            RunResult result = runInMode(mode, code, optimize);
+            EXPECT_EQ(result.error, "");
+            EXPECT_EQ(result.variables[name], value);
+        }
+    }
+}
+
+TEST(DeepNestingTest, Parentheses) {
+    std::string code = "BEGIN x := " + std::string(kDeep, '(') + "7" + std::string(kDeep, ')') + " END.";
+    expectDeep(code, "x", 7);
+}
+
+TEST(DeepNestingTest, RightNestedSums) {
+    std::string code = "BEGIN y := 1; x := ";
+    for (int i = 0; i < kDeep; i++) code += "y + (";
+    code += "0" + std::string(kDeep, ')') + " END.";
+    expectDeep(code, "x", kDeep);
+}
+
+TEST(DeepNestingTest, LongChain) {
+    std::string code = "BEGIN y := 3; x := y";
+    for (int i = 0; i < kDeep; i++) code += i % 2 ? " - y" : " + y";
+    code += " END.";
+    expectDeep(code, "x", 3);
+}
+
+TEST(DeepNestingTest, UnaryMinus) {
+    std::string code = "BEGIN x := " + std::string(kDeep + 1, '-') + "5 END.";
+    expectDeep(code, "x", -5);
+}
+
+TEST(DeepNestingTest, Blocks) {
+    std::string code;
+    for (int i = 0; i < kDeep; i++) code += "BEGIN x := " + std::to_string(i) + "; ";
+    code += "y := x";
+    for (int i = 0; i < kDeep; i++) code += " END";
+    code += ".";
+    expectDeep(code, "y", kDeep - 1);
+}
+
+TEST(DeepNestingTest, ErrorsAtDepth) {
+    std::string open = std::string(kDeep, '(');
+    EXPECT_EQ(runInMode(Mode::Bytecode, "BEGIN x := " + open + "1 END.").error, "Invalid syntax");
+    std::string blocks;
+    for (int i = 0; i < kDeep; i++) blocks += "BEGIN ";
+    EXPECT_EQ(runInMode(Mode::Tree, blocks + "END.").error, "Invalid syntax");
+    EXPECT_EQ(runInMode(Mode::Tree, "BEGIN x := " + open + "1 / 0" + std::string(kDeep, ')') + " END.").error,
+              "Division by zero");
+}
+
+TEST(ParserTest, Precedence) {
+    expectSameAsTree("BEGIN a := 2 - 3 - 4; b := 8 / 2 / 2; c := -2 * 3; d := 2 * -3; e := -(1 + 2) * 3 END.");
+    expectSameAsTree("BEGIN a := 1 + 2 * 3 - 4 / 2; b := (1 + 2) * (3 - 4) / 2; c := - - (-(2)) END.");
+    auto result = runInMode(Mode::Tree, "BEGIN a := 2 - 3 - 4; b := 8 / 2 / 2; e := -(1 + 2) * 3 END.", false);
+    EXPECT_EQ(result.variables.at("a"), -5);
+    EXPECT_EQ(result.variables.at("b"), 2);
+    EXPECT_EQ(result.variables.at("e"), -9);
+}
+
+TEST(ParserTest, UnbalancedParens) {
+    Interpreter interp;
+    EXPECT_THROW(interp.interpret("BEGIN x := (1 + 2 END."), std::runtime_error);
+    EXPECT_THROW(interp.interpret("BEGIN x := (1 + 2)) END."), std::runtime_error);
+    EXPECT_THROW(interp.interpret("BEGIN x := () END."), std::runtime_error);
+    EXPECT_THROW(interp.interpret("BEGIN x := 1 + END."), std::runtime_error);
+}
+
+// Статистика
+
+TEST(StatsTest, CountsAndPhases) {
+    Interpreter interp;
+    Stats stats;
+    auto result = interp.interpret("BEGIN a := 1 + 2; BEGIN b := a * -a; ; a := b END END.", &stats);
+    EXPECT_EQ(result, Interpreter().interpret("BEGIN a := 1 + 2; BEGIN b := a * -a; ; a := b END END."));
+
+    EXPECT_EQ(stats.tokens, 23u);
+    EXPECT_EQ(stats.nodes[static_cast<size_t>(NodeKind::Compound)], 2u);
+    EXPECT_EQ(stats.nodes[static_cast<size_t>(NodeKind::Assign)], 3u);
+    EXPECT_EQ(stats.nodes[static_cast<size_t>(NodeKind::Var)], 6u);
+    EXPECT_EQ(stats.nodes[static_cast<size_t>(NodeKind::BinOp)], 2u);
+    EXPECT_EQ(stats.nodes[static_cast<size_t>(NodeKind::UnaryOp)], 1u);
+    EXPECT_EQ(stats.nodes[static_cast<size_t>(NodeKind::Num)], 2u);
+    EXPECT_EQ(stats.nodes[static_cast<size_t>(NodeKind::NoOp)], 1u);
+    EXPECT_EQ(stats.total_nodes(), 17u);
+    EXPECT_EQ(stats.variables, 2u);
+    // после оптимизации все значения известны: два присваивания констант
+    EXPECT_EQ(stats.reads, 0u);
+    EXPECT_EQ(stats.writes, 2u);
+    EXPECT_GT(stats.arena_bytes, 0u);
+    EXPECT_GE(stats.lex_seconds, 0.0);
+    EXPECT_GE(stats.eval_seconds, 0.0);
+
+    interp.setOptimize(false);
+    interp.interpret("BEGIN a := 1 + 2; BEGIN b := a * -a; ; a := b END END.", &stats);
+    EXPECT_EQ(stats.reads, 3u);
+    EXPECT_EQ(stats.writes, 3u);
+
+    std::stringstream out;
+    stats.report(out);
+    EXPECT_NE(out.str().find("Tokens: 23"), std::string::npos);
+    EXPECT_NE(out.str().find("Assign 3"), std::string::npos);
+}
+
+// Со статистикой ошибки те же, что и без неё
+TEST(StatsTest, SameErrors) {
+    for (const char* code : {"BEGIN x := * @ END.", "BEGIN x := 1 / 0 END.", "BEGIN @ END.", "BEGIN x := y END."}) {
+        Interpreter plain, counted;
+        Stats stats;
+        std::string expected, actual;
+        try { plain.interpret(code); } catch (const std::runtime_error& e) { expected = e.what(); }
+        try { counted.interpret(code, &stats); } catch (const std::runtime_error& e) { actual = e.what(); }
+        EXPECT_FALSE(expected.empty());
+        EXPECT_EQ(actual, expected) << code;
+    }
+}
+
+// Пакетный режим
+
+TEST(BatchTest, ResultsInInputOrder) {
+    std::vector<size_t> order;
+    tppl::run_ordered<size_t>(1000, 8,
+        [](unsigned, size_t i) { return i * i; },
+        [&](size_t i, size_t& square) {
+            EXPECT_EQ(square, i * i);
+            order.push_back(i);
+        });
+    ASSERT_EQ(order.size(), 1000u);
+    for (size_t i = 0; i < order.size(); i++) EXPECT_EQ(order[i], i);
+}
+
+// Потоки пула переиспользуют интерпретаторы; результат каждой программы
+// тот же, что у отдельного интерпретатора
+TEST(BatchTest, SameAsSingleRuns) {
+    ProgramGenerator generator(7);
+    std::vector<std::string> programs;
+    for (int i = 0; i < 300; i++) programs.push_back(generator.program(1 + i % 12));
+    programs.push_back("BEGIN x := * END.");
+    programs.push_back("BEGIN END.");
+
+    BatchRunner runner(4);
+    for (int round = 0; round < 2; round++) {
+        size_t seen = 0;
+        runner.run(programs.size(),
+            [&](Interpreter& interp, size_t i) { return run_program(interp, programs[i]); },
+            [&](size_t i, BatchResult& result) {
+                EXPECT_EQ(i, seen++);
+                RunResult expected = runInMode(Mode::Bytecode, programs[i]);
+                std::ostringstream out;
+                if (expected.error.empty()) print_variables(out, expected.variables);
+                EXPECT_EQ(result.output, out.str()) << programs[i];
+                EXPECT_EQ(result.error, expected.error) << programs[i];
+            });
+        EXPECT_EQ(seen, programs.size());
+    }
+}
+
+TEST(BatchTest, ReadLengthPrefixed) {
+    std::istringstream in("14\nBEGIN x:=1 END\n0\n\n 6\nBEGIN\n");
+    std::string program;
+    ASSERT_TRUE(read_program(in, program));
+    EXPECT_EQ(program, "BEGIN x:=1 END");
+    ASSERT_TRUE(read_program(in, program));
+    EXPECT_EQ(program, "");
+    ASSERT_TRUE(read_program(in, program));
+    EXPECT_EQ(program, "BEGIN\n");
+    EXPECT_FALSE(read_program(in, program));
+
+    std::istringstream garbage("BEGIN END.");
+    EXPECT_THROW(read_program(garbage, program), std::runtime_error);
+    std::istringstream truncated("100\nBEGIN END.");
+    EXPECT_THROW(read_program(truncated, program), std::runtime_error);
+}